@@ -1,7 +1,29 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <fstream>
-#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unordered_map>
+#include <unistd.h>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 // Reads in a text file
 // Writes :
@@ -18,13 +40,13 @@ using namespace std;
 class Frequency {
 public:
   Frequency() : value{""}, frequency{0} {}
-  Frequency(const string& v, const int& f) : value{v}, frequency{f} {}
+  Frequency(const string& v, const uint64_t& f) : value{v}, frequency{f} {}
   ~Frequency() {}
 
   void setValue(const string &v) { value = v; }
-  void setFrequency(const int &f) { frequency = f; }
-  string getValue() const { return value; }
-  int getFrequency() const { return frequency; }
+  void setFrequency(const uint64_t &f) { frequency = f; }
+  const string &getValue() const { return value; }
+  uint64_t getFrequency() const { return frequency; }
 
   Frequency &operator=(const Frequency &rhs) {
     if (this != &rhs) {
@@ -47,7 +69,7 @@ public:
 
 private:
   string value;
-  int frequency;
+  uint64_t frequency;
 };
 
 
@@ -167,6 +189,13 @@ public:
     return -1;
   }
 
+  // O(1) insertion at the head, for filling the list from sorted data
+  void prependElement(Frequency &f) {
+    Node *newNode = new Node(f);
+    newNode->setNext(head);
+    head = newNode;
+  }
+
   void swap(Node *a, Node *b) {
     Frequency temp = a->getData();
     a->setData(b->getData());
@@ -174,47 +203,19 @@ public:
   }
 
   void SortByValue() {
-    Node *current = head;
-    Node *smallest;
-    Node *pTrav;
-
-    while (current != NULL) {
-      pTrav = current->getNext();
-      smallest = current;
-
-      while (pTrav != NULL) {
-        if (pTrav->getData().getValue() < smallest->getData().getValue())
-          smallest = pTrav;
-        pTrav = pTrav->getNext();
-      }
-
-      if (smallest->getData().getValue() < current->getData().getValue())
-        swap(current, smallest);
-
-      current = current->getNext();
-    }
+    mergeSort([](Node *a, Node *b) {
+      return a->getData().getValue() < b->getData().getValue();
+    });
   }
 
+  // Ascending frequency, ties in ascending value order
   void SortByFrequency() {
-    Node *current = head;
-    Node *smallest;
-    Node *pTrav;
-
-    while (current != NULL) {
-      pTrav = current->getNext();
-      smallest = current;
-
-      while (pTrav != NULL) {
-        if (pTrav->getData().getFrequency() < smallest->getData().getFrequency())
-          smallest = pTrav;
-        pTrav = pTrav->getNext();
-      }
-
-      if (smallest->getData().getFrequency() < current->getData().getFrequency())
-        swap(current, smallest);
-
-      current = current->getNext();
-    }
+    mergeSort([](Node *a, Node *b) {
+      const Frequency &x = a->getData(), &y = b->getData();
+      if (x.getFrequency() != y.getFrequency())
+        return x.getFrequency() < y.getFrequency();
+      return x.getValue() < y.getValue();
+    });
   }
 
   void printList() {
@@ -226,7 +227,8 @@ public:
   }
 
 
-  void printHistogram(int maxWordLength, string filename = HISTOGRAM_FILE) {
+  // False when the file could not be written
+  bool printHistogram(int maxWordLength, string filename = HISTOGRAM_FILE) {
     ofstream outFile(filename);
     Node *current = head;
 
@@ -236,13 +238,15 @@ public:
       for (int i = 0; i < maxWordLength - current->getData().getValue().length(); i++)
         outFile << " ";
 
-      for (int i = 0; i < current->getData().getFrequency(); i++) 
+      for (uint64_t i = 0; i < current->getData().getFrequency(); i++) 
         outFile << "*";
 
       outFile << current->getData().getFrequency()<< endl;
 
       current = current->getNext();
     }
+    outFile.close();
+    return !outFile.fail();
   }
 
   friend ostream& operator<<(ostream &os, const List &l) {
@@ -256,46 +260,777 @@ public:
 
 private:
   Node* head;
+
+  // Stable bottom-up merge sort. runs[i] holds a sorted run of 2^i nodes;
+  // every node taken off the list is carried up through the runs like a
+  // binary counter, so merges stay on recently touched nodes. Nodes are
+  // relinked and no Frequency is ever copied.
+  template <class Less> void mergeSort(Less less) {
+    Node *runs[64] = {};
+    int used = 0;
+
+    while (head) {
+      Node *carry = head;
+      head = head->getNext();
+      carry->setNext(NULL);
+
+      int i = 0;
+      for (; i < used && runs[i]; i++) {
+        carry = merge(runs[i], carry, less); // runs[i] came first
+        runs[i] = NULL;
+      }
+      runs[i] = carry;
+      if (i == used)
+        used++;
+    }
+
+    for (int i = 0; i < used; i++)
+      if (runs[i])
+        head = head ? merge(runs[i], head, less) : runs[i];
+
+    Node *previous = NULL;
+    for (Node *n = head; n; previous = n, n = n->getNext())
+      n->setPre(previous);
+  }
+
+  // Merges two sorted chains, ties taken from a to keep the sort stable
+  template <class Less> static Node *merge(Node *a, Node *b, Less less) {
+    Node front;
+    Node *tail = &front;
+    while (a && b) {
+      if (less(b, a)) {
+        tail->setNext(b);
+        b = b->getNext();
+      } else {
+        tail->setNext(a);
+        a = a->getNext();
+      }
+      tail = tail->getNext();
+    }
+    tail->setNext(a ? a : b);
+    return front.getNext();
+  }
+};
+
+// Chunked storage for key bytes. Stored keys never move, so a table can keep
+// pointers to them while it grows.
+class Arena {
+public:
+  Arena() : used{BLOCK_SIZE}, capacity{BLOCK_SIZE} {}
+
+  const char *store(const char *s, size_t n) {
+    if (used + n > capacity) {
+      capacity = max(BLOCK_SIZE, n);
+      blocks.emplace_back(new char[capacity]);
+      used = 0;
+    }
+    char *p = blocks.back().get() + used;
+    memcpy(p, s, n);
+    used += n;
+    return p;
+  }
+
+private:
+  static constexpr size_t BLOCK_SIZE = 1 << 16;
+  vector<unique_ptr<char[]>> blocks;
+  size_t used, capacity;
+};
+
+// Open-addressing (linear probing) table from string keys to counts. Slots
+// keep the key hash, so growing never touches the key bytes again.
+class CountTable {
+public:
+  CountTable() : slots(16), entries{0} {}
+
+  void add(string_view key, uint64_t count = 1) { add(key, hash(key), count); }
+
+  void merge(const CountTable &other) {
+    for (const Slot &slot : other.slots)
+      if (slot.key)
+        add(string_view(slot.key, slot.length), slot.hash, slot.count);
+  }
+
+  size_t size() const { return entries; }
+
+  // FNV-1a
+  static uint64_t hash(string_view key) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : key)
+      h = (h ^ c) * 1099511628211ull;
+    return h;
+  }
+
+  // Entry count, then length, bytes and count of every key
+  void write(ostream &out) const {
+    uint64_t n = entries;
+    out.write((const char *)&n, sizeof(n));
+    for (const Slot &slot : slots) {
+      if (!slot.key)
+        continue;
+      uint32_t length = slot.length;
+      out.write((const char *)&length, sizeof(length));
+      out.write(slot.key, length);
+      out.write((const char *)&slot.count, sizeof(slot.count));
+    }
+  }
+  // Adds the written entries to the table
+  bool read(istream &in) {
+    uint64_t n;
+    if (!in.read((char *)&n, sizeof(n)))
+      return false;
+    string key;
+    for (; n > 0; n--) {
+      uint32_t length;
+      uint64_t count;
+      if (!in.read((char *)&length, sizeof(length)))
+        return false;
+      key.resize(length);
+      if (!in.read(&key[0], length) || !in.read((char *)&count, sizeof(count)))
+        return false;
+      add(key, count);
+    }
+    return true;
+  }
+
+  // Entries in ascending key order, sorted only when asked for
+  void sorted(vector<pair<string_view, uint64_t>> &out) const {
+    out.clear();
+    out.reserve(entries);
+    for (const Slot &slot : slots)
+      if (slot.key)
+        out.push_back({string_view(slot.key, slot.length), slot.count});
+    sort(out.begin(), out.end());
+  }
+
+private:
+  struct Slot {
+    const char *key = nullptr;
+    size_t length = 0;
+    uint64_t hash = 0;
+    uint64_t count = 0;
+  };
+
+  vector<Slot> slots;
+  size_t entries;
+  Arena arena;
+
+  void add(string_view key, uint64_t h, uint64_t count) {
+    if ((entries + 1) * 10 > slots.size() * 7)
+      grow();
+
+    size_t mask = slots.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+      Slot &slot = slots[i];
+      if (!slot.key) {
+        slot.key = arena.store(key.data(), key.size());
+        slot.length = key.size();
+        slot.hash = h;
+        slot.count = count;
+        entries++;
+        return;
+      }
+      if (slot.hash == h && slot.length == key.size() &&
+          memcmp(slot.key, key.data(), key.size()) == 0) {
+        slot.count += count;
+        return;
+      }
+    }
+  }
+
+  void grow() {
+    vector<Slot> old(slots.size() * 2);
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (const Slot &slot : old) {
+      if (!slot.key)
+        continue;
+      size_t i = slot.hash & mask;
+      while (slots[i].key)
+        i = (i + 1) & mask;
+      slots[i] = slot;
+    }
+  }
+};
+
+// Byte counts over a raw buffer. Bytes are read eight at a time and spread
+// over four sub-histograms, so a run of one value does not stall on
+// back-to-back increments of the same counter.
+class CharacterHistogram {
+public:
+  CharacterHistogram() { memset(counts, 0, sizeof(counts)); }
+
+  void add(const char *begin, const char *end) {
+    uint64_t sub[4][256] = {};
+    const char *p = begin;
+    for (; end - p >= 8; p += 8) {
+      uint64_t word;
+      memcpy(&word, p, 8);
+      sub[0][word & 0xff]++;
+      sub[1][(word >> 8) & 0xff]++;
+      sub[2][(word >> 16) & 0xff]++;
+      sub[3][(word >> 24) & 0xff]++;
+      sub[0][(word >> 32) & 0xff]++;
+      sub[1][(word >> 40) & 0xff]++;
+      sub[2][(word >> 48) & 0xff]++;
+      sub[3][word >> 56]++;
+    }
+    for (; p < end; p++)
+      sub[0][(unsigned char)*p]++;
+
+    for (int c = 0; c < 256; c++)
+      counts[c] += sub[0][c] + sub[1][c] + sub[2][c] + sub[3][c];
+  }
+
+  void merge(const CharacterHistogram &other) {
+    for (int c = 0; c < 256; c++)
+      counts[c] += other.counts[c];
+  }
+
+  void write(ostream &out) const {
+    out.write((const char *)counts, sizeof(counts));
+  }
+  bool read(istream &in) {
+    return (bool)in.read((char *)counts, sizeof(counts));
+  }
+
+  // Tokens are split at whitespace, so only the other bytes are characters.
+  // They are moved into list in ascending value order.
+  void fillList(List &list) const {
+    for (int c = 255; c >= 0; c--) {
+      if (!counts[c] || isspace(c))
+        continue;
+      Frequency f(string(1, (char)c), counts[c]);
+      list.prependElement(f);
+    }
+  }
+
+private:
+  uint64_t counts[256];
+};
+
+// Count-Min sketch: depth rows of width counters. An estimate never
+// undercounts, and overcounts by at most 2 / width of the total with
+// probability 1 - 2^-depth.
+class CountMinSketch {
+public:
+  CountMinSketch(size_t width = 1 << 14, int depth = 4)
+      : width{width}, depth{depth}, cells(width * depth, 0) {}
+
+  // Adds count and returns the new estimate
+  uint64_t add(uint64_t hash, uint64_t count) {
+    uint64_t estimate = numeric_limits<uint64_t>::max();
+    for (int i = 0; i < depth; i++) {
+      uint64_t &cell = cells[cellOf(hash, i)];
+      cell += count;
+      estimate = min(estimate, cell);
+    }
+    return estimate;
+  }
+
+  uint64_t estimate(uint64_t hash) const {
+    uint64_t estimate = numeric_limits<uint64_t>::max();
+    for (int i = 0; i < depth; i++)
+      estimate = min(estimate, cells[cellOf(hash, i)]);
+    return estimate;
+  }
+
+  void merge(const CountMinSketch &other) {
+    for (size_t i = 0; i < cells.size(); i++)
+      cells[i] += other.cells[i];
+  }
+
+private:
+  size_t width;
+  int depth;
+  vector<uint64_t> cells;
+
+  // Row i hashes with h1 + i * h2, both halves of the key hash
+  size_t cellOf(uint64_t hash, int i) const {
+    uint32_t h1 = hash, h2 = (hash >> 32) | 1;
+    return i * width + (h1 + (uint64_t)i * h2) % width;
+  }
+};
+
+// Space-Saving summary of the heaviest keys in at most capacity entries. An
+// unseen key replaces the entry with the lowest count and inherits that
+// count as its error, so count - error <= true count <= count, and every
+// key whose true count is above total / capacity is in the summary. With a
+// sketch, a new key starts from its sketch estimate instead.
+class SpaceSaving {
+public:
+  struct Entry {
+    string key;
+    uint64_t count;
+    uint64_t error;
+  };
+
+  SpaceSaving(size_t capacity, bool useSketch = false)
+      : capacity{max<size_t>(1, capacity)},
+        sketch{useSketch ? new CountMinSketch() : nullptr} {
+    // Entries never move, the index keeps views of their keys
+    entries.reserve(this->capacity);
+  }
+
+  void add(string_view key) {
+    uint64_t estimate = numeric_limits<uint64_t>::max();
+    if (sketch)
+      estimate = sketch->add(CountTable::hash(key), 1);
+    insert(key, 1, 0, estimate);
+  }
+
+  // A key missing from one summary may still have occurred there up to
+  // absentBound, so it gets that much added to its count and its error. The
+  // capacity heaviest entries of the union are kept.
+  void merge(const SpaceSaving &other) {
+    vector<Entry> merged;
+    merged.reserve(entries.size() + other.entries.size());
+    for (const Entry &e : other.entries)
+      if (index.find(e.key) == index.end()) {
+        uint64_t bound = absentBound(e.key);
+        merged.push_back({e.key, e.count + bound, e.error + bound});
+      }
+    for (Entry &e : entries) {
+      auto found = other.index.find(e.key);
+      if (found != other.index.end()) {
+        e.count += other.entries[found->second].count;
+        e.error += other.entries[found->second].error;
+      } else {
+        uint64_t bound = other.absentBound(e.key);
+        e.count += bound;
+        e.error += bound;
+      }
+      merged.push_back(std::move(e));
+    }
+    if (merged.size() > capacity) {
+      nth_element(merged.begin(), merged.begin() + capacity, merged.end(),
+                  heavier);
+      merged.resize(capacity);
+    }
+
+    // clear keeps the reserved storage, so the index views stay valid
+    entries.clear();
+    index.clear();
+    heap.clear();
+    position.clear();
+    for (Entry &e : merged) {
+      entries.push_back(std::move(e));
+      index[entries.back().key] = entries.size() - 1;
+      heap.push_back(entries.size() - 1);
+      position.push_back(heap.size() - 1);
+    }
+    for (size_t i = heap.size() / 2; i-- > 0;)
+      siftDown(i);
+
+    if (sketch && other.sketch)
+      sketch->merge(*other.sketch);
+  }
+
+  // The k entries with the highest counts
+  void top(size_t k, vector<Entry> &out) const {
+    out = entries;
+    if (k < out.size()) {
+      nth_element(out.begin(), out.begin() + k, out.end(), heavier);
+      out.resize(k);
+    }
+  }
+
+private:
+  size_t capacity;
+  unique_ptr<CountMinSketch> sketch;
+  vector<Entry> entries;
+  unordered_map<string_view, size_t> index; // key -> entry
+  vector<size_t> heap;                      // entries, min count on top
+  vector<size_t> position;                  // entry -> place in heap
+
+  static bool heavier(const Entry &a, const Entry &b) {
+    return a.count > b.count || (a.count == b.count && a.key < b.key);
+  }
+
+  // Upper bound of the count of a key not in the summary: without a sketch
+  // no evicted key counted more than the lowest entry.
+  uint64_t absentBound(string_view key) const {
+    if (sketch)
+      return sketch->estimate(CountTable::hash(key));
+    return entries.size() < capacity ? 0 : entries[heap[0]].count;
+  }
+
+  void insert(string_view key, uint64_t count, uint64_t error,
+              uint64_t estimate) {
+    auto found = index.find(key);
+    if (found != index.end()) {
+      entries[found->second].count += count;
+      entries[found->second].error += error;
+      siftDown(position[found->second]);
+      return;
+    }
+
+    if (entries.size() < capacity) {
+      entries.push_back({string(key), count, error});
+      index[entries.back().key] = entries.size() - 1;
+      heap.push_back(entries.size() - 1);
+      position.push_back(heap.size() - 1);
+      siftUp(heap.size() - 1);
+      return;
+    }
+
+    size_t victim = heap[0];
+    Entry &e = entries[victim];
+    uint64_t floor = e.count;
+    index.erase(e.key);
+    e.key = string(key);
+    // Once a sketch estimate lowered an entry, floor no longer bounds the
+    // evicted keys, so with a sketch only the estimate is used. count - error
+    // stays a lower bound of the true count.
+    e.count = sketch ? estimate : floor + count;
+    e.error = e.count - (count - error);
+    index[e.key] = victim;
+    siftDown(0);
+  }
+
+  void siftUp(size_t i) {
+    while (i > 0) {
+      size_t parent = (i - 1) / 2;
+      if (entries[heap[parent]].count <= entries[heap[i]].count)
+        break;
+      swapHeap(i, parent);
+      i = parent;
+    }
+  }
+
+  void siftDown(size_t i) {
+    while (true) {
+      size_t smallest = i, l = 2 * i + 1, r = l + 1;
+      if (l < heap.size() &&
+          entries[heap[l]].count < entries[heap[smallest]].count)
+        smallest = l;
+      if (r < heap.size() &&
+          entries[heap[r]].count < entries[heap[smallest]].count)
+        smallest = r;
+      if (smallest == i)
+        return;
+      swapHeap(i, smallest);
+      i = smallest;
+    }
+  }
+
+  void swapHeap(size_t i, size_t j) {
+    swap(heap[i], heap[j]);
+    position[heap[i]] = i;
+    position[heap[j]] = j;
+  }
+};
+
+// Bit i of each mask describes byte i of a 64-byte block
+struct ByteClasses {
+  uint64_t space;  // ' ', '\t', '\n', '\v', '\f', '\r'
+  uint64_t letter; // ASCII_CHARACTERS
+};
+
+inline ByteClasses classify(const char *p) {
+  ByteClasses c = {0, 0};
+#if defined(__SSE2__)
+  // Signed compares keep bytes >= 0x80 out of both ranges
+  const __m128i blank = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t' - 1),
+                cr = _mm_set1_epi8('\r' + 1), caseBit = _mm_set1_epi8(0x20),
+                a = _mm_set1_epi8('a' - 1), z = _mm_set1_epi8('z' + 1);
+  for (int i = 0; i < 4; i++) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+    __m128i space = _mm_or_si128(
+        _mm_cmpeq_epi8(v, blank),
+        _mm_and_si128(_mm_cmpgt_epi8(v, tab), _mm_cmplt_epi8(v, cr)));
+    __m128i lower = _mm_or_si128(v, caseBit);
+    __m128i letter =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, a), _mm_cmplt_epi8(lower, z));
+    c.space |= (uint64_t)(uint16_t)_mm_movemask_epi8(space) << (16 * i);
+    c.letter |= (uint64_t)(uint16_t)_mm_movemask_epi8(letter) << (16 * i);
+  }
+#else
+  for (int i = 0; i < 64; i++) {
+    unsigned char b = p[i];
+    if (b == ' ' || (b >= '\t' && b <= '\r'))
+      c.space |= 1ull << i;
+    if ((unsigned char)((b | 0x20) - 'a') < 26)
+      c.letter |= 1ull << i;
+  }
+#endif
+  return c;
+}
+
+// Everything one pass over a piece of text produces. Pieces counted
+// separately, e.g. on different threads, are combined with merge.
+struct TextCounts {
+  CountTable words;
+  CharacterHistogram characters;
+  int maxWordLength = 0;
+  uint64_t textLength = 0;
+  // Set in approximate mode, words are then counted here instead
+  unique_ptr<SpaceSaving> heavyHitters;
+
+  void approximate(size_t capacity, bool useSketch) {
+    heavyHitters.reset(new SpaceSaving(capacity, useSketch));
+  }
+
+  void count(const char *begin, const char *end) {
+    characters.add(begin, end);
+    textLength += end - begin;
+
+    // Words are found 64 bytes at a time from the whitespace mask; a word is
+    // valid when the letter mask covers all of its bytes
+    const char *start = nullptr;
+    bool letters = true;
+    for (const char *block = begin; block < end; block += 64) {
+      ByteClasses c;
+      if (end - block >= 64) {
+        c = classify(block);
+      } else { // the tail, padded with spaces
+        char tail[64];
+        memset(tail, ' ', 64);
+        memcpy(tail, block, end - block);
+        c = classify(tail);
+      }
+
+      for (int i = 0; i < 64;) {
+        if (!start) {
+          uint64_t rest = ~c.space >> i;
+          if (!rest)
+            break;
+          i += __builtin_ctzll(rest);
+          start = block + i;
+          letters = true;
+        }
+
+        uint64_t spaces = c.space >> i;
+        int wordEnd = spaces ? i + __builtin_ctzll(spaces) : 64;
+        int width = wordEnd - i;
+        uint64_t span = (width == 64 ? ~0ull : (1ull << width) - 1) << i;
+        letters = letters && (c.letter & span) == span;
+        if (wordEnd == 64) // the word goes on in the next block
+          break;
+
+        addWord(start, block + wordEnd, letters);
+        start = nullptr;
+        i = wordEnd;
+      }
+    }
+    if (start)
+      addWord(start, end, letters);
+  }
+
+  void addWord(const char *begin, const char *end, bool letters) {
+    // Only words made of letters are counted
+    if (!letters)
+      return;
+
+    if (end - begin > maxWordLength)
+      maxWordLength = end - begin;
+
+    if (heavyHitters)
+      heavyHitters->add(string_view(begin, end - begin));
+    else
+      words.add(string_view(begin, end - begin));
+  }
+
+  void write(ostream &out) const {
+    out.write((const char *)&maxWordLength, sizeof(maxWordLength));
+    out.write((const char *)&textLength, sizeof(textLength));
+    characters.write(out);
+    words.write(out);
+  }
+  bool read(istream &in) {
+    return in.read((char *)&maxWordLength, sizeof(maxWordLength)) &&
+           in.read((char *)&textLength, sizeof(textLength)) &&
+           characters.read(in) && words.read(in);
+  }
+
+  void merge(const TextCounts &other) {
+    words.merge(other.words);
+    if (heavyHitters && other.heavyHitters)
+      heavyHitters->merge(*other.heavyHitters);
+    characters.merge(other.characters);
+    maxWordLength = max(maxWordLength, other.maxWordLength);
+    textLength += other.textLength;
+  }
+};
+
+// Read-only mapping of a whole file, unmapped on destruction
+class MappedFile {
+public:
+  MappedFile() : data{nullptr}, size{0} {}
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() {
+    if (data)
+      munmap((void *)data, size);
+  }
+
+  bool open(const string &filepath) {
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size > 0) { // an empty file cannot be mapped
+      void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ok = p != MAP_FAILED;
+      if (ok) {
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        data = (const char *)p;
+        size = st.st_size;
+      }
+    }
+    close(fd);
+    return ok;
+  }
+
+  string_view view() const { return string_view(data, size); }
+
+private:
+  const char *data;
+  size_t size;
+};
+
+struct AnalysisOptions {
+  int threads = 1;
+  // Tokenize the mapped file in place instead of reading it into memory
+  bool mapInput = false;
+  // Read the input in blocks, "-" being standard input; only the counts
+  // stay in memory
+  bool streamInput = false;
+  // Approximate mode when nonzero: only the topWords heaviest words are
+  // reported, from a Space-Saving summary of 4 * topWords entries, so
+  // memory no longer grows with the vocabulary. Characters stay exact.
+  size_t topWords = 0;
+  // The summary reserves all its entries up front
+  static constexpr size_t MAX_TOP_WORDS = 1 << 20;
+  // Back the summary with a Count-Min sketch for tighter new-key counts
+  bool sketch = false;
+  // Incremental mode for append-only input: the exact counts and the byte
+  // offset analyzed so far are kept in this file, and a later run only reads
+  // the bytes appended since. Not combined with topWords.
+  string indexFile;
+  // Corpus mode: also write the statistics of every file into this
+  // directory
+  string perFileDirectory;
 };
 
 class WordStatistics {
 public:
   WordStatistics() : text{""}, wordList{new List()}, characterList{new List()} {};
-  explicit WordStatistics(const string &, const string &, const string &);
+  explicit WordStatistics(const string &, const string &, const string &,
+                          const AnalysisOptions &options = AnalysisOptions());
+  // Corpus mode: all the files are analyzed as one text, on a pool of
+  // options.threads threads
+  WordStatistics(const vector<string> &, const string &, const string &,
+                 const AnalysisOptions &options = AnalysisOptions());
   ~WordStatistics() {
     delete wordList;
     delete characterList;
   }
   void analyze();
+  // Streaming analysis, adding to the counts so far
+  void analyze(istream &in);
+  void analyze(int fd);
   void outputStatistics();
 
+  // Moves the counts of table into list, in ascending value order
+  static void fillList(const CountTable &table, List &list);
+  // Moves the k heaviest words of summary into list, in ascending value
+  // order; the counts are the summary's upper bounds
+  static void fillList(const SpaceSaving &summary, size_t k, List &list);
+  // Reports a file it cannot write and returns false
+  static bool writeStatistics(const TextCounts &counts, size_t topWords,
+                              List &words, List &characters,
+                              const string &histogramFile,
+                              const string &characterFile);
+
 private:
   string text;
+  MappedFile mapping;
+  string_view input; // text, or the mapped file
   string histogramFile;
   string characterFile;
 
-  int maxWordLength;
+  AnalysisOptions options;
   List* wordList;
   List* characterList;
+
+  // Counting happens here, the lists are only filled for output
+  TextCounts counts;
+
+  static constexpr size_t STREAM_BLOCK_SIZE = 1 << 20;
+  // Corpus files up to this size are batched, larger ones are split
+  static constexpr uint64_t CORPUS_CHUNK_SIZE = 16 << 20;
+
+  TextCounts newCounts() const;
+  void countRange(const char *begin, const char *end);
+  // Merges all the parts into parts[0], pairs of them in parallel
+  static void reduce(vector<TextCounts> &parts);
+  // File name of a corpus file's statistics under --per-file, without the
+  // ".hist.txt" or ".freq.txt" suffix
+  static string outputName(const string &filepath);
+  // Leaves room for the suffix within NAME_MAX (255) bytes
+  static constexpr size_t MAX_OUTPUT_NAME = 240;
+  void analyzeCorpus(const vector<string> &filepaths);
+  // read(buffer, n) returns the number of bytes read, 0 at the end. With
+  // tail, a last word that may still be growing is stored there instead of
+  // being counted. Returns the number of bytes counted.
+  template <class Read> uint64_t analyzeStream(Read read, string *tail = NULL);
+  static size_t readFile(int fd, char *buffer, size_t n);
+
+  void analyzeIncremental(int fd);
+  // Offset the index was written at, 0 without a usable index
+  uint64_t loadIndex(int fd);
+  void saveIndex(int fd, uint64_t offset) const;
+  // Identifies the indexed file: hash of its first bytes
+  static uint64_t fingerprint(int fd, uint64_t offset);
 };
 
-WordStatistics::WordStatistics(const string& filepath, const string& output, const string& character)
+WordStatistics::WordStatistics(const string& filepath, const string& output, const string& character, const AnalysisOptions &options)
   : text{""}, 
-  maxWordLength{0}, 
+  options{options}, 
   wordList{new List()}, 
   characterList{new List()}, 
   histogramFile{output}, 
   characterFile{character} 
 {
   ifstream inFile;
+  if (options.topWords)
+    counts.approximate(4 * options.topWords, options.sketch);
   try {
     cout << "Loading input file..." << endl;
-    inFile.open(filepath);
-    if (!inFile) {
-      throw filepath;
+    if (!options.indexFile.empty() && !options.topWords) {
+      int fd = ::open(filepath.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw filepath;
+      analyzeIncremental(fd);
+      close(fd);
+    } else if (options.streamInput) {
+      if (filepath == "-") {
+        analyze(cin);
+      } else {
+        int fd = ::open(filepath.c_str(), O_RDONLY);
+        if (fd < 0)
+          throw filepath;
+        analyze(fd);
+        close(fd);
+      }
+    } else if (options.mapInput) {
+      if (!mapping.open(filepath))
+        throw filepath;
+      // Stop at the first NUL, like getline below
+      input = mapping.view();
+      input = input.substr(0, input.find('\0'));
+      analyze();
+    } else {
+      inFile.open(filepath);
+      if (!inFile) {
+        throw filepath;
+      }
+      getline(inFile, text, '\0');
+      input = text;
+      analyze();
     }
-    getline(inFile, text, '\0');
-    analyze();
     cout << "File loaded successfully!" << endl;
     inFile.close();
   } catch (const string& filepath) {
@@ -304,53 +1039,429 @@ WordStatistics::WordStatistics(const string& filepath, const string& output, con
 }
 
 void WordStatistics::analyze() {
-  stringstream ss(text);
-  string word;
-  Node* target = NULL;
-
-  while (ss >> word) {
-    for (int i = 0; i < word.length(); i++) {
-      string character = word.substr(i, 1);
-      target = characterList->findElement(character);
-      if (target) {
-        Frequency &data = target->getData(); 
-        data.setFrequency(data.getFrequency() + 1);
-      } else {
-        Frequency f(character, 1);
-        characterList->addElement(f);
-      }
+  countRange(input.data(), input.data() + input.size());
+}
+
+void WordStatistics::analyze(istream &in) {
+  analyzeStream([&in](char *buffer, size_t n) {
+    in.read(buffer, n);
+    return (size_t)in.gcount();
+  });
+}
+
+void WordStatistics::analyze(int fd) {
+  analyzeStream(
+      [fd](char *buffer, size_t n) { return readFile(fd, buffer, n); });
+}
+
+size_t WordStatistics::readFile(int fd, char *buffer, size_t n) {
+  ssize_t r;
+  do
+    r = ::read(fd, buffer, n);
+  while (r < 0 && errno == EINTR);
+  return r < 0 ? 0 : (size_t)r;
+}
+
+template <class Read>
+uint64_t WordStatistics::analyzeStream(Read read, string *tail) {
+  vector<char> buffer(STREAM_BLOCK_SIZE * max(1, options.threads));
+  size_t carried = 0;
+  uint64_t counted = 0;
+  bool done = false;
+
+  while (!done) {
+    // A single word filling the whole buffer
+    if (carried == buffer.size())
+      buffer.resize(buffer.size() * 2);
+
+    char *block = buffer.data() + carried;
+    size_t n = read(block, buffer.size() - carried);
+    // The text ends at the first NUL, as in the other input modes
+    char *nul = (char *)memchr(block, '\0', n);
+    if (nul)
+      n = nul - block;
+    done = nul || n == 0;
+
+    // The trailing partial word is carried over to the next block
+    size_t filled = carried + n, cut = filled;
+    if (!done || tail)
+      while (cut > 0 && !isspace((unsigned char)buffer[cut - 1]))
+        cut--;
+    countRange(buffer.data(), buffer.data() + cut);
+    counted += cut;
+
+    carried = filled - cut;
+    if (done && tail)
+      tail->assign(buffer.data() + cut, carried);
+    memmove(buffer.data(), buffer.data() + cut, carried);
+  }
+  return counted;
+}
+
+void WordStatistics::analyzeIncremental(int fd) {
+  uint64_t offset = loadIndex(fd);
+  lseek(fd, offset, SEEK_SET);
+
+  // The index must not include a last word the log may still extend, so
+  // it is saved before that word is counted for this run's output
+  string tail;
+  offset += analyzeStream(
+      [fd](char *buffer, size_t n) { return readFile(fd, buffer, n); }, &tail);
+  saveIndex(fd, offset);
+  countRange(tail.data(), tail.data() + tail.size());
+}
+
+uint64_t WordStatistics::fingerprint(int fd, uint64_t offset) {
+  char prefix[4096];
+  ssize_t n = pread(fd, prefix, min<uint64_t>(offset, sizeof(prefix)), 0);
+  return CountTable::hash(string_view(prefix, max<ssize_t>(n, 0)));
+}
+
+uint64_t WordStatistics::loadIndex(int fd) {
+  ifstream in(options.indexFile, ios::binary);
+  char magic[4];
+  uint64_t offset, hash;
+  if (!in || !in.read(magic, 4) || memcmp(magic, "WSI2", 4) != 0 ||
+      !in.read((char *)&offset, sizeof(offset)) ||
+      !in.read((char *)&hash, sizeof(hash)))
+    return 0;
+
+  // A shorter or different file was not produced by appending
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < offset ||
+      fingerprint(fd, offset) != hash)
+    return 0;
+
+  TextCounts saved;
+  if (!saved.read(in))
+    return 0;
+  counts = move(saved);
+  return offset;
+}
+
+void WordStatistics::saveIndex(int fd, uint64_t offset) const {
+  uint64_t hash = fingerprint(fd, offset);
+
+  // Written aside and renamed, so a crash never leaves half an index
+  string temporary = options.indexFile + ".tmp";
+  ofstream out(temporary, ios::binary | ios::trunc);
+  out.write("WSI2", 4);
+  out.write((const char *)&offset, sizeof(offset));
+  out.write((const char *)&hash, sizeof(hash));
+  counts.write(out);
+  out.close();
+  if (out)
+    rename(temporary.c_str(), options.indexFile.c_str());
+  else
+    cerr << "Error: Unable to write index " << options.indexFile << endl;
+}
+
+void WordStatistics::countRange(const char *begin, const char *end) {
+  int threads = max(1, options.threads);
+  if (threads == 1) {
+    counts.count(begin, end);
+    return;
+  }
+
+  // Chunks end at whitespace, so no word is split between two threads
+  vector<const char *> bounds = {begin};
+  for (int i = 1; i < threads; i++) {
+    const char *p = max(bounds.back(), begin + (end - begin) * i / threads);
+    while (p < end && !isspace((unsigned char)*p))
+      p++;
+    bounds.push_back(p);
+  }
+  bounds.push_back(end);
+
+  vector<TextCounts> parts;
+  for (int i = 0; i < threads; i++)
+    parts.push_back(newCounts());
+  vector<thread> pool;
+  for (int i = 0; i < threads; i++)
+    pool.emplace_back([&, i] { parts[i].count(bounds[i], bounds[i + 1]); });
+  for (auto &t : pool)
+    t.join();
+
+  reduce(parts);
+  counts.merge(parts[0]);
+}
+
+TextCounts WordStatistics::newCounts() const {
+  TextCounts part;
+  if (options.topWords)
+    part.approximate(4 * options.topWords, options.sketch);
+  return part;
+}
+
+void WordStatistics::reduce(vector<TextCounts> &parts) {
+  // Tree reduction: each round merges disjoint pairs of tables in parallel
+  vector<thread> pool;
+  for (size_t step = 1; step < parts.size(); step *= 2) {
+    pool.clear();
+    for (size_t i = 0; i + step < parts.size(); i += 2 * step)
+      pool.emplace_back([&, i, step] { parts[i].merge(parts[i + step]); });
+    for (auto &t : pool)
+      t.join();
+  }
+}
+
+WordStatistics::WordStatistics(const vector<string> &filepaths,
+                               const string &output, const string &character,
+                               const AnalysisOptions &options)
+    : text{""}, histogramFile{output}, characterFile{character},
+      options{options}, wordList{new List()}, characterList{new List()} {
+  cout << "Loading " << filepaths.size() << " input files..." << endl;
+  counts = newCounts();
+  analyzeCorpus(filepaths);
+  cout << "Files loaded successfully!" << endl;
+}
+
+void WordStatistics::analyzeCorpus(const vector<string> &filepaths) {
+  // [begin, end) of a large file, chunk number chunk of the file's chunks
+  // starting at firstChunk; a small file is one task marked by
+  // end == UINT64_MAX
+  struct Task {
+    size_t file;
+    uint64_t begin, end;
+    size_t firstChunk, chunk;
+  };
+  vector<vector<Task>> batches;
+  vector<Task> small;
+  uint64_t smallBytes = 0;
+  size_t chunks = 0;
+  // Chunks of each large file not counted yet, guarded by the file's lock
+  vector<size_t> remaining(filepaths.size(), 0);
+
+  for (size_t f = 0; f < filepaths.size(); f++) {
+    struct stat st;
+    if (stat(filepaths[f].c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+      cerr << "Error: Unable to open file " << filepaths[f] << endl;
+      continue;
     }
 
-    // Check if it is a valid word
-    if (word.find_first_not_of(ASCII_CHARACTERS) != string::npos)
+    // Small files are batched, so every task is worth taking
+    uint64_t size = st.st_size;
+    if (size <= CORPUS_CHUNK_SIZE) {
+      small.push_back({f, 0, UINT64_MAX, 0, 0});
+      smallBytes += size;
+      if (smallBytes >= CORPUS_CHUNK_SIZE) {
+        batches.push_back(move(small));
+        small.clear();
+        smallBytes = 0;
+      }
       continue;
+    }
 
-    if (word.length() > maxWordLength)
-      maxWordLength = word.length();
+    // Large files are split into chunks. The text ends at the first NUL,
+    // which every chunk looks for in its own range when it is counted
+    size_t first = chunks;
+    for (uint64_t b = 0; b < size; b += CORPUS_CHUNK_SIZE) {
+      batches.push_back(
+          {{f, b, min(size, b + CORPUS_CHUNK_SIZE), first, chunks++}});
+      remaining[f]++;
+    }
+  }
+  if (!small.empty())
+    batches.push_back(move(small));
 
-    target = wordList->findElement(word);
-    if (target) {
-      Frequency &data = target->getData();
-      data.setFrequency(data.getFrequency() + 1);
-    } else {
-      Frequency f(word, 1);
-      wordList->addElement(f);
+  int threads = max(1, options.threads);
+  vector<TextCounts> parts;
+  for (int i = 0; i < threads; i++)
+    parts.push_back(newCounts());
+
+  // With --per-file, a file's counts only exist while its chunks are
+  // counted: the worker finishing its last task writes them out and folds
+  // them into its part
+  bool perFile = !options.perFileDirectory.empty();
+  vector<unique_ptr<TextCounts>> files(perFile ? filepaths.size() : 0);
+  vector<mutex> fileLocks(files.size());
+  if (perFile)
+    filesystem::create_directories(options.perFileDirectory);
+  auto finishFile = [&](size_t f, const TextCounts &fileCounts, int i) {
+    if (fileCounts.textLength > 0) {
+      string prefix =
+          options.perFileDirectory + "/" + outputName(filepaths[f]);
+      List words, characters;
+      writeStatistics(fileCounts, options.topWords, words, characters,
+                      prefix + ".hist.txt", prefix + ".freq.txt");
     }
+    parts[i].merge(fileCounts);
+  };
+
+  // Lowest NUL position found in each file, and the chunks done looking
+  vector<atomic<uint64_t>> firstNul(filepaths.size());
+  for (auto &nul : firstNul)
+    nul = UINT64_MAX;
+  vector<atomic<bool>> scanned(chunks);
+
+  // A chunk holds the words that start in it: both of its ends move forward
+  // to the next word start or NUL, so neighbouring chunks meet exactly
+  auto wordStart = [](string_view text, uint64_t pos) {
+    while (pos > 0 && pos < text.size() && text[pos] != '\0' &&
+           !isspace((unsigned char)text[pos - 1]))
+      pos++;
+    return pos;
+  };
+
+  atomic<size_t> next{0};
+  vector<thread> pool;
+  for (int i = 0; i < threads; i++)
+    pool.emplace_back([&, i] {
+      for (size_t b; (b = next++) < batches.size();)
+        for (const Task &task : batches[b]) {
+          MappedFile mapping;
+          if (!mapping.open(filepaths[task.file]))
+            cerr << "Error: Unable to open file " + filepaths[task.file] +
+                        "\n";
+
+          // A file that failed to open, or a chunk past the NUL, counts an
+          // empty range, so its file still gets finished
+          string_view text = mapping.view();
+          uint64_t begin = 0, end = 0;
+          if (task.end == UINT64_MAX) {
+            text = text.substr(0, text.find('\0'));
+            end = text.size();
+          } else {
+            uint64_t nul = UINT64_MAX;
+            if (task.begin < text.size()) {
+              uint64_t stop = min<uint64_t>(task.end, text.size());
+              const void *p =
+                  memchr(text.data() + task.begin, '\0', stop - task.begin);
+              if (p)
+                nul = (const char *)p - text.data();
+            }
+            uint64_t seen = firstNul[task.file];
+            while (nul < seen &&
+                   !firstNul[task.file].compare_exchange_weak(seen, nul))
+              ;
+            scanned[task.chunk] = true;
+
+            // Chunks are taken in order, so the earlier chunks of the file
+            // are already looking and a NUL in them drops this one
+            for (size_t c = task.firstChunk; c < task.chunk; c++)
+              while (!scanned[c])
+                this_thread::yield();
+            text = text.substr(0, min<uint64_t>(text.size(),
+                                                firstNul[task.file]));
+            if (task.begin < text.size()) {
+              begin = wordStart(text, task.begin);
+              end = wordStart(text, min<uint64_t>(task.end, text.size()));
+            }
+          }
+
+          if (!perFile) {
+            parts[i].count(text.data() + begin, text.data() + end);
+            continue;
+          }
+          TextCounts part = newCounts();
+          part.count(text.data() + begin, text.data() + end);
+          if (task.end == UINT64_MAX) { // the whole file
+            finishFile(task.file, part, i);
+            continue;
+          }
+          unique_ptr<TextCounts> done;
+          {
+            lock_guard<mutex> lock(fileLocks[task.file]);
+            unique_ptr<TextCounts> &file = files[task.file];
+            if (file)
+              file->merge(part);
+            else
+              file.reset(new TextCounts(move(part)));
+            if (--remaining[task.file] == 0)
+              done = move(file);
+          }
+          if (done)
+            finishFile(task.file, *done, i);
+        }
+    });
+  for (auto &t : pool)
+    t.join();
+
+  reduce(parts);
+  counts.merge(parts[0]);
+}
+
+string WordStatistics::outputName(const string &filepath) {
+  // '%' and '/' are escaped, so different paths never share a name
+  string name;
+  for (char c : filepath)
+    if (c == '%')
+      name += "%25";
+    else if (c == '/')
+      name += "%2F";
+    else
+      name += c;
+
+  // Too long for one directory entry: the hash of the path tells the
+  // names apart, followed by the end of the name
+  if (name.size() > MAX_OUTPUT_NAME) {
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx",
+             (unsigned long long)CountTable::hash(filepath));
+    name = string(hash) + "~" + name.substr(name.size() - 128);
+  }
+  return name;
+}
+
+void WordStatistics::fillList(const CountTable &table, List &list) {
+  vector<pair<string_view, uint64_t>> entries;
+  table.sorted(entries);
+  for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+    Frequency f(string(it->first), it->second);
+    list.prependElement(f);
+  }
+}
+
+void WordStatistics::fillList(const SpaceSaving &summary, size_t k,
+                              List &list) {
+  vector<SpaceSaving::Entry> entries;
+  summary.top(k, entries);
+  sort(entries.begin(), entries.end(),
+       [](const SpaceSaving::Entry &a, const SpaceSaving::Entry &b) {
+         return a.key < b.key;
+       });
+  for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+    Frequency f(it->key, it->count);
+    list.prependElement(f);
   }
 }
 
 void WordStatistics::outputStatistics() {
-  if (text.empty()) {
+  if (counts.textLength == 0) {
     cerr << "Error: No text to analyze" << endl;
     return;
   }
 
+  writeStatistics(counts, options.topWords, *wordList, *characterList,
+                  histogramFile, characterFile);
+}
+
+bool WordStatistics::writeStatistics(const TextCounts &counts,
+                                     size_t topWords, List &words,
+                                     List &characters,
+                                     const string &histogramFile,
+                                     const string &characterFile) {
   ofstream outFile(characterFile);
 
-  wordList->SortByValue();
-  wordList->printHistogram(maxWordLength, histogramFile);
-  characterList->SortByFrequency();
-  outFile << *characterList << endl;
+  // Both lists come out of fillList already sorted by value
+  if (topWords)
+    fillList(*counts.heavyHitters, topWords, words);
+  else
+    fillList(counts.words, words);
+  counts.characters.fillList(characters);
+  bool ok = true;
+  if (!words.printHistogram(counts.maxWordLength, histogramFile)) {
+    cerr << "Error: Unable to write file " + histogramFile + "\n";
+    ok = false;
+  }
+  characters.SortByFrequency();
+  outFile << characters << endl;
+  outFile.close();
+  if (outFile.fail()) {
+    cerr << "Error: Unable to write file " + characterFile + "\n";
+    ok = false;
+  }
+  return ok;
 }
 
 int main (int argc, char *argv[]) {
@@ -358,12 +1469,78 @@ int main (int argc, char *argv[]) {
   string inputFileName;
   string outputFileName;
   string characterFileName;
+  AnalysisOptions options;
+  bool corpus = false;
+
+  // Options:
+  //   --threads N    split the analysis over N threads
+  //   --mmap         map the input file instead of reading it
+  //   --stream       read it in blocks; an input file "-" then reads the text
+  //                  following the file names on stdin
+  //   --top K        report only the K most frequent words, approximately
+  //   --sketch       back that summary with a Count-Min sketch
+  //   --index FILE   keep the counts in FILE and only analyze what was
+  //                  appended to the input since the last run
+  //   --corpus       the input is a directory, or a file listing one input
+  //                  path per line, analyzed as a single text
+  //   --per-file DIR with --corpus, also write every file's statistics to DIR,
+  //                  named after its path with '/' written as %2F, or
+  //                  after a hash of the path when that name is too long
+  for (int i = 1; i < argc; i++) {
+    string option = argv[i];
+    if (option == "--threads" && i + 1 < argc)
+      options.threads = atoi(argv[++i]);
+    else if (option == "--mmap")
+      options.mapInput = true;
+    else if (option == "--stream")
+      options.streamInput = true;
+    else if (option == "--top" && i + 1 < argc) {
+      // strtoull would accept a sign and wrap "-5" around
+      const char *value = argv[++i];
+      char *end;
+      errno = 0;
+      unsigned long long k = strtoull(value, &end, 10);
+      if (!isdigit((unsigned char)*value) || *end || errno == ERANGE ||
+          k == 0 || k > AnalysisOptions::MAX_TOP_WORDS) {
+        cerr << "Error: --top takes a word count from 1 to "
+             << AnalysisOptions::MAX_TOP_WORDS << endl;
+        return 1;
+      }
+      options.topWords = k;
+    }
+    else if (option == "--sketch")
+      options.sketch = true;
+    else if (option == "--index" && i + 1 < argc)
+      options.indexFile = argv[++i];
+    else if (option == "--corpus")
+      corpus = true;
+    else if (option == "--per-file" && i + 1 < argc)
+      options.perFileDirectory = argv[++i];
+  }
 
   std::getline(std::cin, inputFileName);
   std::getline(std::cin, outputFileName);
   std::getline(std::cin, characterFileName);
   
-  analysis = new WordStatistics(inputFileName, outputFileName, characterFileName);
+  if (corpus) {
+    vector<string> files;
+    error_code error;
+    if (filesystem::is_directory(inputFileName, error)) {
+      for (const auto &entry :
+           filesystem::recursive_directory_iterator(inputFileName, error))
+        if (entry.is_regular_file(error))
+          files.push_back(entry.path().string());
+      sort(files.begin(), files.end());
+    } else {
+      ifstream list(inputFileName);
+      string path;
+      while (getline(list, path))
+        if (!path.empty())
+          files.push_back(path);
+    }
+    analysis = new WordStatistics(files, outputFileName, characterFileName, options);
+  } else
+    analysis = new WordStatistics(inputFileName, outputFileName, characterFileName, options);
   analysis->outputStatistics();
   cout << "Analysis completed!" << endl;
 
@@ -3,15 +3,123 @@
 #include <vector>
 using namespace std;
 
-class Graph {
+// Packed edge endpoint: 8 bytes instead of a heap allocated vector<int>
+struct AdjacentEdge {
+  int to;
+  int weight;
+};
+
+// Non-owning view of the edges adjacent to one vertex
+class EdgeSpan {
+public:
+  EdgeSpan(const AdjacentEdge *b, const AdjacentEdge *e) : first(b), last(e) {}
+  const AdjacentEdge *begin() const { return first; }
+  const AdjacentEdge *end() const { return last; }
+  size_t size() const { return last - first; }
+
+private:
+  const AdjacentEdge *first;
+  const AdjacentEdge *last;
+};
+
+/* Storage policies: Resize(n), Add(u, v, weight) for the edge u -> v and
+   Edges(u) returning the EdgeSpan of u */
+
+// V x V weights, 0 meaning no edge. Edges(u) builds the row, in vertex order,
+// into a scratch buffer, so its span is only valid until the next call.
+class MatrixStorage {
+public:
+  void Resize(int n) {
+    size = n;
+    cells.assign(n * n, 0);
+  }
+  void Add(int u, int v, int weight) { cells[u * size + v] = weight; }
+  EdgeSpan Edges(int u) {
+    row.clear();
+    for (int v = 0; v < size; v++)
+      if (cells[u * size + v])
+        row.push_back({v, cells[u * size + v]});
+    return EdgeSpan(row.data(), row.data() + row.size());
+  }
+
+private:
+  int size = 0;
+  vector<int> cells;
+  vector<AdjacentEdge> row;
+};
+
+// One contiguous edge array per vertex
+class ListStorage {
+public:
+  void Resize(int n) { lists.resize(n); }
+  void Add(int u, int v, int weight) { lists[u].push_back({v, weight}); }
+  EdgeSpan Edges(int u) {
+    return EdgeSpan(lists[u].data(), lists[u].data() + lists[u].size());
+  }
+
+private:
+  vector<vector<AdjacentEdge>> lists;
+};
+
+// Compressed sparse rows: edges are collected first and packed into a
+// single array, in insertion order, the first time they are read
+class CSRStorage {
+public:
+  void Resize(int n) {
+    size = n;
+    built = false;
+  }
+  void Add(int u, int v, int weight) {
+    pending.push_back({u, {v, weight}});
+    built = false;
+  }
+  EdgeSpan Edges(int u) {
+    if (!built)
+      Build();
+    return EdgeSpan(edges.data() + offsets[u], edges.data() + offsets[u + 1]);
+  }
+
+private:
+  int size = 0;
+  bool built = false;
+  vector<pair<int, AdjacentEdge>> pending;
+  vector<int> offsets;
+  vector<AdjacentEdge> edges;
+
+  // Merges the edges added since the last Build into the packed arrays,
+  // keeping insertion order per vertex, and releases the pending list
+  void Build() {
+    int packed = offsets.empty() ? 0 : min(size, (int)offsets.size() - 1);
+    vector<int> merged(size + 1, 0);
+    for (int u = 0; u < packed; u++)
+      merged[u + 1] = offsets[u + 1] - offsets[u];
+    for (auto &e : pending)
+      merged[e.first + 1]++;
+    for (int i = 0; i < size; i++)
+      merged[i + 1] += merged[i];
+    vector<AdjacentEdge> packedEdges(merged[size]);
+    vector<int> fill(merged.begin(), merged.end() - 1);
+    for (int u = 0; u < packed; u++)
+      for (int i = offsets[u]; i < offsets[u + 1]; i++)
+        packedEdges[fill[u]++] = edges[i];
+    for (auto &e : pending)
+      packedEdges[fill[e.first]++] = e.second;
+    offsets.swap(merged);
+    edges.swap(packedEdges);
+    vector<pair<int, AdjacentEdge>>().swap(pending);
+    built = true;
+  }
+};
+
+template <class Storage = ListStorage> class Graph {
   /* objects: A nonempty set of vertices and a set of
      undirected edges where each edge is a pair of vertices */
 public:
   Graph(); // Create an empty graph
   void InsertVertex(int v);
-  void InsertEdge(int u, int v, int weight);
+  void InsertEdge(int u, int v, int weight = 1);
   bool IsEmpty(); // if graph has no vertices return TRUE
-  list<vector<int>> Adjacent_List(int u);
+  EdgeSpan Adjacent_List(int u);
   void PrintAdjacentMatrix();
   void PrintAdjacentList();
 
@@ -19,49 +127,50 @@ private:
   int NumberVertices;
   int NumberEdges;
   list<int> vertices;
-  vector<vector<int>> adjacent_matrix;
-  vector<list<vector<int>>> adjacent_list;
+  Storage adjacent;
   // return a list of all vertices that are adjacent to v
 };
 
-Graph::Graph() : NumberVertices(0), NumberEdges(0) {};
-bool Graph::IsEmpty() { return (vertices.size() == 0); }
+template <class Storage>
+Graph<Storage>::Graph() : NumberVertices(0), NumberEdges(0){};
+template <class Storage> bool Graph<Storage>::IsEmpty() {
+  return (vertices.size() == 0);
+}
 
-list<vector<int>> Graph::Adjacent_List(int i) { return adjacent_list[i]; }
+template <class Storage> EdgeSpan Graph<Storage>::Adjacent_List(int i) {
+  return adjacent.Edges(i);
+}
 
-void Graph::InsertVertex(int v) {
+template <class Storage> void Graph<Storage>::InsertVertex(int v) {
   vertices.push_back(v);
   NumberVertices++;
 }
-void Graph::InsertEdge(int u, int v, int weight = 1) {
-  if (adjacent_matrix.size() == 0) {
-    for (int i = 0; i < vertices.size(); i++)
-      adjacent_matrix.push_back(vector<int>(vertices.size()));
-  }
-  if (adjacent_list.size() == 0) {
-    for (int i = 0; i < vertices.size(); i++)
-      adjacent_list.push_back(list<vector<int>>());
-  }
+template <class Storage>
+void Graph<Storage>::InsertEdge(int u, int v, int weight) {
+  if (NumberEdges == 0)
+    adjacent.Resize(vertices.size());
 
-  adjacent_matrix[u][v] = adjacent_matrix[v][u] = weight;
-  adjacent_list[u].push_back({v, weight});
-  adjacent_list[v].push_back({u, weight});
+  adjacent.Add(u, v, weight);
+  adjacent.Add(v, u, weight);
   NumberEdges++;
 }
 
-void Graph::PrintAdjacentMatrix() {
+template <class Storage> void Graph<Storage>::PrintAdjacentMatrix() {
+  vector<int> row(vertices.size());
   for (int i = 0; i < vertices.size(); i++) {
+    fill(row.begin(), row.end(), 0);
+    for (auto &it : adjacent.Edges(i))
+      row[it.to] = it.weight;
     for (int j = 0; j < vertices.size(); j++) {
-      if (adjacent_matrix[i][j])
-        cout << "(" << i << ", " << j << ", " << adjacent_matrix[i][j] << ")"
-             << endl;
+      if (row[j])
+        cout << "(" << i << ", " << j << ", " << row[j] << ")" << endl;
     }
   }
 }
-void Graph::PrintAdjacentList() {
+template <class Storage> void Graph<Storage>::PrintAdjacentList() {
   for (int i = 0; i < vertices.size(); i++) {
-    for (auto it : adjacent_list[i]) {
-      cout << "(" << i << ", " << it[0] << ", " << it[1] << ")" << endl;
+    for (auto &it : adjacent.Edges(i)) {
+      cout << "(" << i << ", " << it.to << ", " << it.weight << ")" << endl;
     }
   }
 }
@@ -72,7 +181,7 @@ int main() {
   int N; // number of input vertices
   int M; // number of input edges
   /* Template for reading graph with edges with weight = 1*/
-  Graph g1;
+  Graph<> g1;
   cin >> N >> M;
   for (int i = 0; i < N; i++) {
     cin >> u;
@@ -88,12 +197,12 @@ int main() {
   cout << endl;
   for (int i = 0; i < N; i++) {
     auto edge_list = g1.Adjacent_List(i);
-    for (auto it : edge_list) {
-      cout << "(" << i << ", " << it[0] << ", " << it[1] << ")" << endl;
+    for (auto &it : edge_list) {
+      cout << "(" << i << ", " << it.to << ", " << it.weight << ")" << endl;
     }
   }
   /* Template for reading graph with edges with weight*/
-  Graph g2;
+  Graph<> g2;
   cin >> N >> M;
   for (int i = 0; i < N; i++) {
     cin >> u;
@@ -1,12 +1,92 @@
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <queue>
 #include <stack>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Instrumentation counters, compiled in with -DGRAPH_STATS. Without it every
+// STATS_* macro expands to nothing, so the engines pay no cost at all.
+#ifdef GRAPH_STATS
+#include <atomic>
+#include <chrono>
+
+class GraphStats {
+public:
+  std::atomic<long long> edgesScanned = 0;
+  std::atomic<long long> relaxations = 0;
+  std::atomic<long long> heapPushes = 0;
+  std::atomic<long long> heapPops = 0;
+  // Lazy deletion stands in for decrease-key, stale pops measure its cost
+  std::atomic<long long> stalePops = 0;
+  std::atomic<long long> finds = 0;
+  std::atomic<long long> compressionSteps = 0;
+  std::atomic<long long> bytesAllocated = 0;
+  std::vector<long long> frontierSizes;
+  std::vector<std::pair<std::string, double>> phases;
+
+  static GraphStats &instance() {
+    static GraphStats stats;
+    return stats;
+  };
+
+  // Times the enclosing scope as one phase
+  class Phase {
+  public:
+    Phase(const std::string &n)
+        : name(n), start(std::chrono::steady_clock::now()) {};
+    ~Phase() {
+      instance().phases.push_back(
+          {name, std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()});
+    };
+
+  private:
+    std::string name;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  void dump(std::ostream &out) const {
+    out << "{\"edgesScanned\": " << edgesScanned
+        << ", \"relaxations\": " << relaxations
+        << ", \"heapPushes\": " << heapPushes << ", \"heapPops\": " << heapPops
+        << ", \"stalePops\": " << stalePops << ", \"finds\": " << finds
+        << ", \"compressionSteps\": " << compressionSteps
+        << ", \"bytesAllocated\": " << bytesAllocated
+        << ", \"frontierSizes\": [";
+    for (size_t i = 0; i < frontierSizes.size(); i++)
+      out << (i ? ", " : "") << frontierSizes[i];
+    out << "], \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++)
+      out << (i ? ", " : "") << "{\"name\": \"" << phases[i].first
+          << "\", \"seconds\": " << phases[i].second << "}";
+    out << "]}" << std::endl;
+  };
+};
+
+#define STATS_ADD(counter, n) (GraphStats::instance().counter += (n))
+#define STATS_FRONTIER(size)                                                   \
+  GraphStats::instance().frontierSizes.push_back(size)
+#define STATS_PHASE(name) GraphStats::Phase statsPhase(name)
+#define STATS_DUMP(out) GraphStats::instance().dump(out)
+#else
+#define STATS_ADD(counter, n) ((void)0)
+#define STATS_FRONTIER(size) ((void)0)
+#define STATS_PHASE(name)
+#define STATS_DUMP(out) ((void)0)
+#endif
+
 template <class T> class Node {
 public:
   Node() : next(nullptr) {};
@@ -175,6 +255,371 @@ private:
   std::array<Vertex *, 2> vertices;
 };
 
+class CompressedAdjacency {
+  // Every adjacency list is sorted and stored as the gaps between consecutive
+  // neighbor indices, each gap written as a little-endian base-128 varint
+public:
+  class NeighborIterator {
+  public:
+    NeighborIterator(const uint8_t *p, const uint8_t *e)
+        : pos(p), end(e), current(0) {
+      if (pos != end)
+        current = decode();
+    };
+
+    int operator*() const { return (int)current; };
+    NeighborIterator &operator++() {
+      if (pos != end)
+        current += decode();
+      else
+        pos = nullptr;
+      return *this;
+    };
+    bool operator!=(const NeighborIterator &other) const {
+      return pos != other.pos;
+    };
+
+  private:
+    const uint8_t *pos;
+    const uint8_t *end;
+    uint64_t current;
+
+    uint64_t decode() {
+      uint64_t value = 0;
+      int shift = 0;
+      while (*pos & 0x80) {
+        value |= (uint64_t)(*pos++ & 0x7f) << shift;
+        shift += 7;
+      }
+      value |= (uint64_t)(*pos++) << shift;
+      return value;
+    };
+  };
+
+  class NeighborRange {
+  public:
+    NeighborRange(const uint8_t *b, const uint8_t *e) : first(b), last(e) {};
+    NeighborIterator begin() const {
+      return (first == last) ? end() : NeighborIterator(first, last);
+    };
+    NeighborIterator end() const { return NeighborIterator(nullptr, nullptr); };
+
+  private:
+    const uint8_t *first;
+    const uint8_t *last;
+  };
+
+  CompressedAdjacency() : offsets(1, 0) {};
+
+  // Vertices must be appended in index order
+  void appendVertex(std::vector<int> neighbors) {
+    std::sort(neighbors.begin(), neighbors.end());
+    int previous = 0;
+    for (int n : neighbors) {
+      encode((uint64_t)(n - previous));
+      previous = n;
+    }
+    offsets.push_back(bytes.size());
+  };
+
+  NeighborRange neighbors(int u) const {
+    const uint8_t *base = bytes.data();
+    return NeighborRange(base + offsets[u], base + offsets[u + 1]);
+  };
+
+  // Streaming construction, so the uncompressed graph never has to exist:
+  // startEdges(n), then every edge sorted by (u, v), then finishEdges().
+  // Edges out of order or outside [0, n) are reported and dropped.
+  void startEdges(int n) {
+    bytes.clear();
+    offsets.assign(1, 0);
+    streamSize = n;
+    lastSource = -1;
+    lastTarget = 0;
+  };
+
+  bool appendEdge(int u, int v) {
+    if (u < 0 || u >= streamSize || v < 0 || v >= streamSize) {
+      std::cerr << "Vertex out of range for compressed adjacency: " << u
+                << " " << v << std::endl;
+      return false;
+    }
+    if (u < lastSource || (u == lastSource && v < lastTarget)) {
+      std::cerr << "Edge out of order for compressed adjacency: " << u << " "
+                << v << std::endl;
+      return false;
+    }
+
+    // Close every vertex before u, the bytes of u follow
+    while (getSize() < u)
+      offsets.push_back(bytes.size());
+    encode((uint64_t)(v - (u == lastSource ? lastTarget : 0)));
+    lastSource = u;
+    lastTarget = v;
+    return true;
+  };
+
+  void finishEdges() {
+    while (getSize() < streamSize)
+      offsets.push_back(bytes.size());
+  };
+
+  int getSize() const { return (int)offsets.size() - 1; };
+  size_t getBytes() const {
+    return bytes.size() + offsets.size() * sizeof(uint64_t);
+  };
+
+private:
+  std::vector<uint8_t> bytes;
+  std::vector<uint64_t> offsets;
+  // State of the streaming construction
+  int streamSize = 0;
+  int lastSource = -1;
+  int lastTarget = 0;
+
+  void encode(uint64_t value) {
+    while (value >= 0x80) {
+      bytes.push_back((uint8_t)(value | 0x80));
+      value >>= 7;
+    }
+    bytes.push_back((uint8_t)value);
+  };
+};
+
+class EdgeShards {
+  // Semi-external graph: only per-vertex state is kept in memory, the edges
+  // live in binary shard files (source ranges) and are streamed sequentially
+public:
+  EdgeShards(const std::string &p, int n, int shards = 4)
+      : prefix(p), vertexCount(n), shardCount(shards), writers() {};
+  ~EdgeShards() { close(); };
+
+  // Truncate the shard files and start writing. Edges already on disk are
+  // lost, so this is never done implicitly.
+  bool create() {
+    close();
+    for (int i = 0; i < shardCount; i++) {
+      writers.emplace_back(shardName(i), std::ios::binary | std::ios::trunc);
+      if (!writers.back()) {
+        std::cerr << "Unable to create edge shard " << shardName(i)
+                  << std::endl;
+        writers.clear();
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // Ids must be in [0, vertexCount), other edges are reported and dropped
+  bool addEdge(int u, int v) {
+    if (u < 0 || u >= vertexCount || v < 0 || v >= vertexCount) {
+      std::cerr << "Vertex out of range for edge shards: " << u << " " << v
+                << std::endl;
+      return false;
+    }
+    if (writers.empty()) {
+      std::cerr << "Edge shards are not open for writing" << std::endl;
+      return false;
+    }
+
+    int32_t e[2] = {u, v};
+    std::ofstream &out = writers[shardOf(u)];
+    if (!out.write((const char *)e, sizeof(e))) {
+      std::cerr << "Unable to write edge shard " << shardName(shardOf(u))
+                << std::endl;
+      return false;
+    }
+    return true;
+  };
+
+  // Flush the shard files, must be called before streaming. False when a
+  // shard could not be written completely.
+  bool close() {
+    bool ok = true;
+    for (size_t i = 0; i < writers.size(); i++) {
+      writers[i].close();
+      if (!writers[i]) {
+        std::cerr << "Unable to write edge shard " << shardName((int)i)
+                  << std::endl;
+        ok = false;
+      }
+    }
+    writers.clear();
+    return ok;
+  };
+
+  // False when a shard is missing, unreadable or ends inside an edge
+  template <class F> bool forEachEdge(F visit) const {
+    std::vector<int32_t> buffer(2 * BLOCK_EDGES);
+    for (int i = 0; i < shardCount; i++) {
+      std::ifstream in(shardName(i), std::ios::binary);
+      if (!in) {
+        std::cerr << "Unable to read edge shard " << shardName(i) << std::endl;
+        return false;
+      }
+      while (in) {
+        in.read((char *)buffer.data(), buffer.size() * sizeof(int32_t));
+        if (in.bad() || in.gcount() % (2 * sizeof(int32_t)) != 0) {
+          std::cerr << "Truncated edge shard " << shardName(i) << std::endl;
+          return false;
+        }
+        std::streamsize read = in.gcount() / (2 * sizeof(int32_t));
+        for (std::streamsize j = 0; j < read; j++)
+          visit(buffer[2 * j], buffer[2 * j + 1]);
+      }
+    }
+    return true;
+  };
+
+  // Level of every vertex from start (-1 if unreachable), one pass per
+  // level. False, with level incomplete, when the shards cannot be read.
+  bool BFS(int start, std::vector<int> &level) const {
+    level.assign(vertexCount, -1);
+    if (start < 0 || start >= vertexCount)
+      return true;
+
+    level[start] = 0;
+    STATS_FRONTIER(1);
+    bool changed = true;
+    for (int depth = 0; changed; depth++) {
+      changed = false;
+      long long reached = 0;
+      bool read = forEachEdge([&](int u, int v) {
+        STATS_ADD(edgesScanned, 1);
+        if (level[u] == depth && level[v] == -1) {
+          level[v] = depth + 1;
+          changed = true;
+          reached++;
+        }
+      });
+      if (!read)
+        return false;
+      if (reached)
+        STATS_FRONTIER(reached);
+    }
+    return true;
+  };
+
+  // Weakly connected components by min-label propagation. False, with
+  // component incomplete, when the shards cannot be read.
+  bool connectedComponents(std::vector<int> &component) const {
+    component.resize(vertexCount);
+    for (int i = 0; i < vertexCount; i++)
+      component[i] = i;
+
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      bool read = forEachEdge([&](int u, int v) {
+        STATS_ADD(edgesScanned, 1);
+        int label = std::min(component[u], component[v]);
+        if (component[u] != label || component[v] != label) {
+          component[u] = component[v] = label;
+          changed = true;
+        }
+      });
+      if (!read)
+        return false;
+    }
+    return true;
+  };
+
+  int getSize() const { return vertexCount; };
+
+private:
+  static const int BLOCK_EDGES = 1 << 16;
+  std::string prefix;
+  int vertexCount;
+  int shardCount;
+  std::vector<std::ofstream> writers;
+
+  std::string shardName(int i) const {
+    return prefix + "." + std::to_string(i) + ".edges";
+  };
+  int shardOf(int u) const {
+    return (int)((int64_t)u * shardCount / std::max(vertexCount, 1));
+  };
+};
+
+class SortedAdjacency {
+  // Undirected simple graph in CSR form: every neighbor list is sorted by
+  // vertex index, without duplicates or self loops
+public:
+  SortedAdjacency() : offsets(1, 0) {};
+
+  void build(int n, const std::vector<std::pair<int, int>> &edges) {
+    std::vector<std::vector<int>> lists(n);
+    for (const auto &e : edges) {
+      if (e.first == e.second)
+        continue;
+      lists[e.first].push_back(e.second);
+      lists[e.second].push_back(e.first);
+    }
+
+    offsets.assign(1, 0);
+    targets.clear();
+    for (auto &list : lists) {
+      std::sort(list.begin(), list.end());
+      list.erase(std::unique(list.begin(), list.end()), list.end());
+      targets.insert(targets.end(), list.begin(), list.end());
+      offsets.push_back((int)targets.size());
+    }
+  };
+
+  int getSize() const { return (int)offsets.size() - 1; };
+  int degree(int u) const { return offsets[u + 1] - offsets[u]; };
+  const int *neighbors(int u) const { return targets.data() + offsets[u]; };
+
+  // Calls match(x) for every x in both sorted lists, returns the match count
+  template <class F>
+  static long long intersect(const int *a, int na, const int *b, int nb,
+                             F match) {
+    int i = 0, j = 0;
+    long long count = 0;
+#if defined(__SSE2__)
+    // Compare 4x4 blocks all-against-all by rotating b three times
+    while (i + 4 <= na && j + 4 <= nb) {
+      __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+      __m128i vb = _mm_loadu_si128((const __m128i *)(b + j));
+      __m128i r1 = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+      __m128i r2 = _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2));
+      __m128i r3 = _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3));
+      __m128i eq =
+          _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(va, vb),
+                                    _mm_cmpeq_epi32(va, r1)),
+                       _mm_or_si128(_mm_cmpeq_epi32(va, r2),
+                                    _mm_cmpeq_epi32(va, r3)));
+      for (int mask = _mm_movemask_ps(_mm_castsi128_ps(eq)); mask;
+           mask &= mask - 1, count++)
+        match(a[i + __builtin_ctz(mask)]);
+
+      int aLast = a[i + 3], bLast = b[j + 3];
+      if (aLast <= bLast)
+        i += 4;
+      if (bLast <= aLast)
+        j += 4;
+    }
+#endif
+    while (i < na && j < nb) {
+      if (a[i] < b[j])
+        i++;
+      else if (b[j] < a[i])
+        j++;
+      else {
+        match(a[i]);
+        count++;
+        i++;
+        j++;
+      }
+    }
+    return count;
+  };
+
+private:
+  std::vector<int> offsets;
+  std::vector<int> targets;
+};
+
 class Graph {
 public:
   Graph()
@@ -261,6 +706,9 @@ public:
     Vertex *otherEnd;
 
     q.push(startVertex);
+    STATS_FRONTIER(1);
+    // Vertices left in the current level, and enqueued for the next one
+    long long levelLeft = 1, nextLevel = 0;
 
     while (!q.empty()) {
       currentVertex = q.front();
@@ -271,6 +719,7 @@ public:
 
       currentEdge = currentVertex->getData()->getConnectedEdges()->getHead();
       while (currentEdge) {
+        STATS_ADD(edgesScanned, 1);
         otherEnd =
             currentEdge->getData()->getAnotherEnd(currentVertex->getData());
 
@@ -283,12 +732,318 @@ public:
             copy.pop();
           }
 
-          if (copy.empty())
+          if (copy.empty()) {
             q.push(vertexList->exists(otherEnd));
+            nextLevel++;
+          }
         }
 
         currentEdge = currentEdge->getNext();
       }
+
+      if (--levelLeft == 0) {
+        if (nextLevel)
+          STATS_FRONTIER(nextLevel);
+        levelLeft = nextLevel;
+        nextLevel = 0;
+      }
+    }
+  };
+
+  // Index vertices by their position in the vertex list
+  void getVertexIndex(std::unordered_map<Vertex *, int> &index,
+                      std::vector<int> &labels) const {
+    Node<Vertex *> *v = vertexList->getHead();
+    while (v) {
+      index[v->getData()] = (int)labels.size();
+      labels.push_back(v->getData()->getData());
+      v = v->getNext();
+    }
+  };
+
+  void getCompressedAdjacency(CompressedAdjacency &adj,
+                              std::vector<int> &labels) const {
+    std::unordered_map<Vertex *, int> index;
+    getVertexIndex(index, labels);
+
+    Node<Vertex *> *v = vertexList->getHead();
+    Node<Edge *> *e = nullptr;
+    Vertex *otherEnd = nullptr;
+    while (v) {
+      std::vector<int> neighbors;
+      e = v->getData()->getConnectedEdges()->getHead();
+      while (e) {
+        otherEnd = e->getData()->getAnotherEnd(v->getData());
+        if (otherEnd)
+          neighbors.push_back(index[otherEnd]);
+        e = e->getNext();
+      }
+      adj.appendVertex(neighbors);
+      v = v->getNext();
+    }
+  };
+
+  // Same traversal as BFS, neighbors visited in ascending index order
+  void BFS(const CompressedAdjacency &adj, const std::vector<int> &labels,
+           int start = 0) const {
+    int n = adj.getSize(), u;
+    int s = (int)(std::find(labels.begin(), labels.end(), start) -
+                  labels.begin());
+    if (s == n) {
+      std::cout << "Invalid vertex for BFS" << std::endl;
+      return;
+    }
+
+    std::vector<bool> enqueued(n, false);
+    std::queue<int> q;
+    q.push(s);
+    enqueued[s] = true;
+
+    while (!q.empty()) {
+      // One level per round, so the frontier size is the queue size
+      size_t frontier = q.size();
+      STATS_FRONTIER(frontier);
+      for (size_t i = 0; i < frontier; i++) {
+        u = q.front();
+        q.pop();
+        std::cout << labels[u] << std::endl;
+
+        for (int v : adj.neighbors(u)) {
+          STATS_ADD(edgesScanned, 1);
+          if (!enqueued[v]) {
+            enqueued[v] = true;
+            q.push(v);
+          }
+        }
+      }
+    }
+  };
+
+  // Stream the edges to disk, vertices renumbered by vertex list position.
+  // False when the shards could not be written.
+  bool writeEdgeShards(EdgeShards &shards) const {
+    std::unordered_map<Vertex *, int> index;
+    std::vector<int> labels;
+    getVertexIndex(index, labels);
+    if (!shards.create())
+      return false;
+    bool ok = true;
+
+    Node<Vertex *> *v = vertexList->getHead();
+    Node<Edge *> *e = nullptr;
+    Vertex *otherEnd = nullptr;
+    while (v) {
+      e = v->getData()->getConnectedEdges()->getHead();
+      while (e) {
+        otherEnd = e->getData()->getAnotherEnd(v->getData());
+        if (otherEnd && ok)
+          ok = shards.addEdge(index[v->getData()], index[otherEnd]);
+        e = e->getNext();
+      }
+      v = v->getNext();
+    }
+    return shards.close() && ok;
+  };
+
+  // Runs one BFS per source, batched 64 * Words at a time: every vertex keeps
+  // one bit per traversal of the batch, so an adjacency scan advances all of
+  // them together. visit(source, vertex, depth) is called once per reached
+  // pair, with vertex values rather than indices.
+  template <int Words = 1, class F>
+  void multiSourceBFS(const CompressedAdjacency &adj,
+                      const std::vector<int> &labels,
+                      const std::vector<int> &sources, F visit) const {
+    typedef std::array<uint64_t, Words> Bits;
+    const int batchSize = 64 * Words;
+    int n = adj.getSize();
+
+    for (size_t first = 0; first < sources.size(); first += batchSize) {
+      int count = (int)std::min(sources.size() - first, (size_t)batchSize);
+      std::vector<Bits> seen(n, Bits{}), frontier(n, Bits{}), next(n, Bits{});
+
+      for (int b = 0; b < count; b++) {
+        int s = (int)(std::find(labels.begin(), labels.end(),
+                                sources[first + b]) -
+                      labels.begin());
+        if (s == n)
+          continue;
+        seen[s][b / 64] |= (uint64_t)1 << (b % 64);
+        frontier[s][b / 64] |= (uint64_t)1 << (b % 64);
+        visit(sources[first + b], labels[s], 0);
+      }
+
+      bool active = true;
+      for (int depth = 1; active; depth++) {
+        for (int u = 0; u < n; u++) {
+          bool any = false;
+          for (int w = 0; w < Words; w++)
+            any |= frontier[u][w] != 0;
+          if (!any)
+            continue;
+
+          for (int v : adj.neighbors(u)) {
+            STATS_ADD(edgesScanned, 1);
+            for (int w = 0; w < Words; w++)
+              next[v][w] |= frontier[u][w];
+          }
+        }
+
+        active = false;
+        long long reachedPairs = 0;
+        for (int v = 0; v < n; v++) {
+          for (int w = 0; w < Words; w++) {
+            uint64_t reached = next[v][w] & ~seen[v][w];
+            seen[v][w] |= reached;
+            frontier[v][w] = reached;
+            next[v][w] = 0;
+            active |= reached != 0;
+            reachedPairs += __builtin_popcountll(reached);
+
+            for (; reached; reached &= reached - 1) {
+              int b = w * 64 + __builtin_ctzll(reached);
+              visit(sources[first + b], labels[v], depth);
+            }
+          }
+        }
+        if (reachedPairs)
+          STATS_FRONTIER(reachedPairs);
+      }
+    }
+  };
+
+  // Edges are taken as undirected for the analytics below
+  void getSortedAdjacency(SortedAdjacency &adj,
+                          std::vector<int> &labels) const {
+    std::unordered_map<Vertex *, int> index;
+    std::vector<std::pair<int, int>> edges;
+    getVertexIndex(index, labels);
+
+    Node<Vertex *> *v = vertexList->getHead();
+    Node<Edge *> *e = nullptr;
+    Vertex *otherEnd = nullptr;
+    while (v) {
+      e = v->getData()->getConnectedEdges()->getHead();
+      while (e) {
+        otherEnd = e->getData()->getAnotherEnd(v->getData());
+        if (otherEnd)
+          edges.push_back({index[v->getData()], index[otherEnd]});
+        e = e->getNext();
+      }
+      v = v->getNext();
+    }
+    adj.build((int)labels.size(), edges);
+  };
+
+  // Exact triangle count. Each edge is oriented from the lower to the higher
+  // (degree, index) rank, so every triangle is found exactly once as the
+  // intersection of two oriented lists. perVertex, when given, receives the
+  // number of triangles through each vertex (for clustering coefficients).
+  long long countTriangles(const SortedAdjacency &adj,
+                           std::vector<long long> *perVertex = nullptr,
+                           int threads = 0) const {
+    STATS_PHASE("countTriangles");
+    int n = adj.getSize();
+    auto before = [&adj](int u, int v) {
+      return adj.degree(u) < adj.degree(v) ||
+             (adj.degree(u) == adj.degree(v) && u < v);
+    };
+
+    std::vector<int> offsets(n + 1, 0), targets;
+    for (int u = 0; u < n; u++) {
+      for (int i = 0; i < adj.degree(u); i++)
+        if (before(u, adj.neighbors(u)[i]))
+          targets.push_back(adj.neighbors(u)[i]);
+      offsets[u + 1] = (int)targets.size();
+    }
+
+    if (threads <= 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<long long> totals(threads, 0);
+    std::vector<std::vector<long long>> counts(
+        perVertex ? threads : 0, std::vector<long long>(n, 0));
+    std::atomic<int> nextVertex(0);
+    const int chunk = 64;
+
+    auto work = [&](int t) {
+      int first;
+      while ((first = nextVertex.fetch_add(chunk)) < n) {
+        for (int u = first; u < std::min(first + chunk, n); u++) {
+          const int *out = targets.data() + offsets[u];
+          int outSize = offsets[u + 1] - offsets[u];
+          for (int i = 0; i < outSize; i++) {
+            int v = out[i];
+            totals[t] += SortedAdjacency::intersect(
+                out, outSize, targets.data() + offsets[v],
+                offsets[v + 1] - offsets[v], [&](int w) {
+                  if (perVertex) {
+                    counts[t][u]++;
+                    counts[t][v]++;
+                    counts[t][w]++;
+                  }
+                });
+          }
+        }
+      }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++)
+      pool.emplace_back(work, t);
+    work(0);
+    for (auto &th : pool)
+      th.join();
+
+    if (perVertex) {
+      perVertex->assign(n, 0);
+      for (const auto &c : counts)
+        for (int u = 0; u < n; u++)
+          (*perVertex)[u] += c[u];
+    }
+
+    long long total = 0;
+    for (long long t : totals)
+      total += t;
+    return total;
+  };
+
+  // Core number of every vertex (Batagelj-Zaversnik bucket peeling)
+  void coreNumbers(const SortedAdjacency &adj, std::vector<int> &core) const {
+    STATS_PHASE("coreNumbers");
+    int n = adj.getSize(), maxDegree = 0;
+    core.resize(n);
+    for (int u = 0; u < n; u++) {
+      core[u] = adj.degree(u);
+      maxDegree = std::max(maxDegree, core[u]);
+    }
+
+    // Vertices sorted by degree, with the start of every degree bucket
+    std::vector<int> bucket(maxDegree + 2, 0), order(n), position(n);
+    for (int u = 0; u < n; u++)
+      bucket[core[u] + 1]++;
+    for (int d = 0; d <= maxDegree; d++)
+      bucket[d + 1] += bucket[d];
+    std::vector<int> fill(bucket.begin(), bucket.end() - 1);
+    for (int u = 0; u < n; u++) {
+      position[u] = fill[core[u]]++;
+      order[position[u]] = u;
+    }
+
+    for (int i = 0; i < n; i++) {
+      int u = order[i];
+      for (int k = 0; k < adj.degree(u); k++) {
+        int v = adj.neighbors(u)[k];
+        if (core[v] <= core[u])
+          continue;
+
+        // Move v to the front of its bucket, then shrink it by one
+        int first = order[bucket[core[v]]];
+        if (first != v) {
+          std::swap(order[position[v]], order[bucket[core[v]]]);
+          std::swap(position[v], position[first]);
+        }
+        bucket[core[v]]++;
+        core[v]--;
+      }
     }
   };
 
@@ -382,6 +1137,7 @@ int main() {
   // std::cout << std::endl;
   // g.printAdjacentList();
 
+  STATS_DUMP(std::cerr);
   return 0;
 };
 
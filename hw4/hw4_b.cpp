@@ -6,11 +6,85 @@
 #include <queue>
 #include <stack>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 inline void print(std::string s) { std::cout << s << std::endl; }
 
+// Instrumentation counters, compiled in with -DGRAPH_STATS. Without it every
+// STATS_* macro expands to nothing, so the engines pay no cost at all.
+#ifdef GRAPH_STATS
+#include <atomic>
+#include <chrono>
+
+class GraphStats {
+public:
+  std::atomic<long long> edgesScanned = 0;
+  std::atomic<long long> relaxations = 0;
+  std::atomic<long long> heapPushes = 0;
+  std::atomic<long long> heapPops = 0;
+  // Lazy deletion stands in for decrease-key, stale pops measure its cost
+  std::atomic<long long> stalePops = 0;
+  std::atomic<long long> finds = 0;
+  std::atomic<long long> compressionSteps = 0;
+  std::atomic<long long> bytesAllocated = 0;
+  std::vector<long long> frontierSizes;
+  std::vector<std::pair<std::string, double>> phases;
+
+  static GraphStats &instance() {
+    static GraphStats stats;
+    return stats;
+  };
+
+  // Times the enclosing scope as one phase
+  class Phase {
+  public:
+    Phase(const std::string &n)
+        : name(n), start(std::chrono::steady_clock::now()) {};
+    ~Phase() {
+      instance().phases.push_back(
+          {name, std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()});
+    };
+
+  private:
+    std::string name;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  void dump(std::ostream &out) const {
+    out << "{\"edgesScanned\": " << edgesScanned
+        << ", \"relaxations\": " << relaxations
+        << ", \"heapPushes\": " << heapPushes << ", \"heapPops\": " << heapPops
+        << ", \"stalePops\": " << stalePops << ", \"finds\": " << finds
+        << ", \"compressionSteps\": " << compressionSteps
+        << ", \"bytesAllocated\": " << bytesAllocated
+        << ", \"frontierSizes\": [";
+    for (size_t i = 0; i < frontierSizes.size(); i++)
+      out << (i ? ", " : "") << frontierSizes[i];
+    out << "], \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++)
+      out << (i ? ", " : "") << "{\"name\": \"" << phases[i].first
+          << "\", \"seconds\": " << phases[i].second << "}";
+    out << "]}" << std::endl;
+  };
+};
+
+#define STATS_ADD(counter, n) (GraphStats::instance().counter += (n))
+#define STATS_FRONTIER(size)                                                   \
+  GraphStats::instance().frontierSizes.push_back(size)
+#define STATS_PHASE(name) GraphStats::Phase statsPhase(name)
+#define STATS_DUMP(out) GraphStats::instance().dump(out)
+#else
+#define STATS_ADD(counter, n) ((void)0)
+#define STATS_FRONTIER(size) ((void)0)
+#define STATS_PHASE(name)
+#define STATS_DUMP(out) ((void)0)
+#endif
+
 template <class T> class Node {
 public:
   Node() : next(nullptr) {};
@@ -142,7 +216,11 @@ public:
   void insert(const T &data) {
     if (exists(data))
       return;
+    append(data);
+  };
 
+  // Append without the duplicate check, the caller guarantees uniqueness
+  void append(const T &data) {
     Node<T> *newNode = new Node<T>(data);
     if (!head)
       head = tail = newNode;
@@ -205,6 +283,7 @@ public:
   void setData(const int &d) { data = d; };
 
   void addConnectedEdge(Edge *e) { connectedEdges->insert(e); };
+  void appendConnectedEdge(Edge *e) { connectedEdges->append(e); };
   const NodeList<Edge *> *getConnectedEdges() const { return connectedEdges; };
 
   friend std::ostream &operator<<(std::ostream &out, const Vertex *v) {
@@ -275,6 +354,147 @@ private:
   std::array<Vertex *, 2> vertices;
 };
 
+class DisjointSets {
+  // Union-find over 0 .. n - 1 with union by rank and path halving
+public:
+  DisjointSets(int n) : parent(n), rank(n, 0) {
+    for (int i = 0; i < n; i++)
+      parent[i] = i;
+  };
+
+  int find(int x) {
+    STATS_ADD(finds, 1);
+    while (parent[x] != x) {
+      STATS_ADD(compressionSteps, 1);
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+    return x;
+  };
+
+  // Does not compress, so several threads may call it between unions
+  int root(int x) const {
+    while (parent[x] != x)
+      x = parent[x];
+    return x;
+  };
+
+  // false when x and y already were in the same set
+  bool unite(int x, int y) {
+    x = find(x);
+    y = find(y);
+    if (x == y)
+      return false;
+    if (rank[x] < rank[y])
+      std::swap(x, y);
+    parent[y] = x;
+    if (rank[x] == rank[y])
+      rank[x]++;
+    return true;
+  };
+
+private:
+  std::vector<int> parent;
+  std::vector<int> rank;
+};
+
+class FilterKruskal {
+  // Minimum spanning forest by Filter-Kruskal: the edges are split around a
+  // pivot weight, the light side is solved first, and heavy edges that are
+  // already inside one component are dropped before they are ever sorted.
+  // Splitting and filtering run on several threads.
+public:
+  struct IndexedEdge {
+    int weight;
+    int u;
+    int v;
+    int id;
+  };
+
+  FilterKruskal(int n, int t = 0)
+      : sets(n),
+        threads(t > 0 ? t : std::max(1u, std::thread::hardware_concurrency())) {
+  };
+
+  // Ids of the forest edges, in the order they were taken
+  void run(std::vector<IndexedEdge> edges, std::vector<int> &forest) {
+    forest.clear();
+    solve(edges, forest);
+  };
+
+private:
+  static const size_t BASE_SIZE = 1 << 10; // plain Kruskal below this
+
+  DisjointSets sets;
+  int threads;
+
+  void kruskal(std::vector<IndexedEdge> &edges, std::vector<int> &forest) {
+    std::sort(edges.begin(), edges.end(),
+              [](const IndexedEdge &a, const IndexedEdge &b) {
+                return a.weight < b.weight;
+              });
+    for (const IndexedEdge &e : edges) {
+      STATS_ADD(edgesScanned, 1);
+      if (sets.unite(e.u, e.v))
+        forest.push_back(e.id);
+    }
+  };
+
+  void solve(std::vector<IndexedEdge> &edges, std::vector<int> &forest) {
+    if (edges.size() <= BASE_SIZE) {
+      kruskal(edges, forest);
+      return;
+    }
+
+    int a = edges.front().weight, b = edges[edges.size() / 2].weight,
+        c = edges.back().weight;
+    int pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+    std::vector<IndexedEdge> light, heavy;
+    split(
+        edges, [pivot](const IndexedEdge &e) { return e.weight <= pivot; },
+        light, heavy);
+    std::vector<IndexedEdge>().swap(edges);
+    if (heavy.empty()) { // every weight is at most the pivot
+      kruskal(light, forest);
+      return;
+    }
+    solve(light, forest);
+
+    std::vector<IndexedEdge> crossing, inside;
+    split(
+        heavy,
+        [this](const IndexedEdge &e) {
+          return sets.root(e.u) != sets.root(e.v);
+        },
+        crossing, inside);
+    solve(crossing, forest);
+  };
+
+  // Stable partition, every thread takes one contiguous chunk
+  template <class Pred>
+  void split(const std::vector<IndexedEdge> &edges, Pred pred,
+             std::vector<IndexedEdge> &yes, std::vector<IndexedEdge> &no) {
+    int t = (int)std::min<size_t>(threads, edges.size() / BASE_SIZE + 1);
+    size_t chunk = (edges.size() + t - 1) / t;
+    std::vector<std::vector<IndexedEdge>> yesParts(t), noParts(t);
+    std::vector<std::thread> pool;
+    for (int i = 0; i < t; i++)
+      pool.emplace_back([&, i] {
+        size_t end = std::min(edges.size(), (i + 1) * chunk);
+        for (size_t j = i * chunk; j < end; j++)
+          (pred(edges[j]) ? yesParts[i] : noParts[i]).push_back(edges[j]);
+      });
+    for (auto &th : pool)
+      th.join();
+
+    for (int i = 0; i < t; i++) {
+      yes.insert(yes.end(), yesParts[i].begin(), yesParts[i].end());
+      no.insert(no.end(), noParts[i].begin(), noParts[i].end());
+    }
+  };
+};
+
 class Graph {
 public:
   Graph()
@@ -282,19 +502,7 @@ public:
         edgeList(new NodeList<Edge *>()) {};
   Graph(const Graph &g)
       : vertexList(new NodeList<Vertex *>()), edgeList(new NodeList<Edge *>()) {
-    Node<Vertex *> *currentVertex = g.getVertexList()->getHead();
-    while (currentVertex) {
-      insertVertex(currentVertex->getData()->getData());
-      currentVertex = currentVertex->getNext();
-    }
-
-    Node<Edge *> *currentEdge = g.getEdgeList()->getHead();
-    while (currentEdge) {
-      insertEdge((*currentEdge->getData())[0]->getData(),
-                 (*currentEdge->getData())[1]->getData(),
-                 currentEdge->getData()->getWeight());
-      currentEdge = currentEdge->getNext();
-    }
+    copyFrom(g, nullptr, [](const Edge *) { return true; });
   };
 
   ~Graph() {
@@ -403,6 +611,7 @@ public:
       return;
 
     // Allocate memory for the adjacency matrix
+    STATS_ADD(bytesAllocated, (long long)dim * dim * sizeof(int));
     adjMatrix = new int *[dim];
     for (int i = 0; i < dim; i++)
       adjMatrix[i] = new int[dim];
@@ -453,12 +662,96 @@ public:
   NodeList<Vertex *> *getVertexList() const { return vertexList; };
   NodeList<Edge *> *getEdgeList() const { return edgeList; };
 
-  void minimumCostSpanningTree() const;
+  // Subgraph induced by the given vertex values, sub is expected to be empty
+  void getInducedSubgraph(const std::unordered_set<int> &vertices,
+                          Graph &sub) const {
+    sub.copyFrom(*this, &vertices, [](const Edge *) { return true; });
+  };
+
+  // Subgraph of the edges accepted by keepEdge, with all the vertices
+  template <class Keep> void getEdgeSubgraph(Keep keepEdge, Graph &sub) const {
+    sub.copyFrom(*this, nullptr, keepEdge);
+  };
+
+  // Minimum spanning forest: one tree for every connected component
+  void minimumSpanningForest(std::vector<Edge *> &forest,
+                             int threads = 0) const {
+    std::unordered_map<const Vertex *, int> index;
+    Node<Vertex *> *v = vertexList->getHead();
+    for (int i = 0; v; i++, v = v->getNext())
+      index[v->getData()] = i;
+
+    std::vector<Edge *> byId;
+    std::vector<FilterKruskal::IndexedEdge> edges;
+    Node<Edge *> *e = edgeList->getHead();
+    for (int id = 0; e; id++, e = e->getNext()) {
+      Edge *edge = e->getData();
+      byId.push_back(edge);
+      edges.push_back(
+          {edge->getWeight(), index[(*edge)[0]], index[(*edge)[1]], id});
+    }
+
+    std::vector<int> ids;
+    FilterKruskal(vertexList->getSize(), threads).run(std::move(edges), ids);
+    forest.clear();
+    for (int id : ids)
+      forest.push_back(byId[id]);
+  };
+
+  // forest uses minimumSpanningForest, so disconnected graphs keep every
+  // component
+  void minimumCostSpanningTree(bool forest = false) const;
 
 private:
   NodeList<Vertex *> *vertexList;
   NodeList<Edge *> *edgeList;
 
+  // O(V + E) copy: old vertices and edges are mapped to their copies, which
+  // are appended directly instead of going through insertVertex/insertEdge
+  template <class Keep>
+  void copyFrom(const Graph &g, const std::unordered_set<int> *vertices,
+                Keep keepEdge) {
+    std::unordered_map<const Vertex *, Vertex *> vertexMap;
+    std::unordered_map<const Edge *, Edge *> edgeMap;
+
+    Node<Vertex *> *curVertex = g.getVertexList()->getHead();
+    while (curVertex) {
+      Vertex *v = curVertex->getData();
+      if (!vertices || vertices->count(v->getData())) {
+        vertexMap[v] = new Vertex(v->getData());
+        vertexList->append(vertexMap[v]);
+      }
+      curVertex = curVertex->getNext();
+    }
+
+    Node<Edge *> *curEdge = g.getEdgeList()->getHead();
+    while (curEdge) {
+      Edge *e = curEdge->getData();
+      auto u = vertexMap.find((*e)[0]), v = vertexMap.find((*e)[1]);
+      if (u != vertexMap.end() && v != vertexMap.end() && keepEdge(e)) {
+        edgeMap[e] = new Edge(u->second, v->second, e->getWeight());
+        edgeList->append(edgeMap[e]);
+      }
+      curEdge = curEdge->getNext();
+    }
+
+    // Keep every vertex's adjacency in the original order
+    curVertex = g.getVertexList()->getHead();
+    while (curVertex) {
+      auto v = vertexMap.find(curVertex->getData());
+      if (v != vertexMap.end()) {
+        curEdge = curVertex->getData()->getConnectedEdges()->getHead();
+        while (curEdge) {
+          auto e = edgeMap.find(curEdge->getData());
+          if (e != edgeMap.end())
+            v->second->appendConnectedEdge(e->second);
+          curEdge = curEdge->getNext();
+        }
+      }
+      curVertex = curVertex->getNext();
+    }
+  };
+
 private:
   bool hasCycle() const {
     std::unordered_map<Vertex *, bool> visited;
@@ -488,6 +781,7 @@ private:
 
     Node<Edge *> *curEdge = vertex->getConnectedEdges()->getHead();
     while (curEdge) {
+      STATS_ADD(edgesScanned, 1);
       Vertex *neighbor = curEdge->getData()->getAnotherEnd(vertex);
 
       // Don't count the parent node as part of the cycle
@@ -505,8 +799,19 @@ private:
   }
 };
 
-void Graph::minimumCostSpanningTree() const {
+void Graph::minimumCostSpanningTree(bool forest) const {
   // Using Kruskal's algorithm and adjacent matrix
+  STATS_PHASE("minimumCostSpanningTree");
+  if (forest) {
+    std::vector<Edge *> edges;
+    minimumSpanningForest(edges);
+    std::sort(edges.begin(), edges.end(),
+              [](Edge *a, Edge *b) { return *a < *b; });
+    for (auto &e : edges)
+      std::cout << e << std::endl;
+    return;
+  }
+
   Graph minSpanTree;
   Graph *tmpSpanTree;
   Node<Edge *> *currentEdge;
@@ -518,6 +823,7 @@ void Graph::minimumCostSpanningTree() const {
   int uIndex, vIndex, i, j, minWeight, nVertices = vertexList->getSize();
   while (true) {
     // Find the min weight in the adjacent matrix and the corresponding edge
+    STATS_ADD(edgesScanned, (long long)nVertices * nVertices);
     minWeight = INT_MAX;
     uIndex = vIndex = -1;
     for (i = 0; i < nVertices; i++) {
@@ -597,6 +903,7 @@ int main() {
   // g.printAdjacentMatrix();
   g.minimumCostSpanningTree();
 
+  STATS_DUMP(std::cerr);
   return 0;
 }
 
@@ -1,16 +1,92 @@
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <climits>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <queue>
 #include <stack>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 inline void print(std::string s) { std::cout << s << std::endl; }
 
+// Instrumentation counters, compiled in with -DGRAPH_STATS. Without it every
+// STATS_* macro expands to nothing, so the engines pay no cost at all.
+#ifdef GRAPH_STATS
+#include <atomic>
+#include <chrono>
+
+class GraphStats {
+public:
+  std::atomic<long long> edgesScanned = 0;
+  std::atomic<long long> relaxations = 0;
+  std::atomic<long long> heapPushes = 0;
+  std::atomic<long long> heapPops = 0;
+  // Lazy deletion stands in for decrease-key, stale pops measure its cost
+  std::atomic<long long> stalePops = 0;
+  std::atomic<long long> finds = 0;
+  std::atomic<long long> compressionSteps = 0;
+  std::atomic<long long> bytesAllocated = 0;
+  std::vector<long long> frontierSizes;
+  std::vector<std::pair<std::string, double>> phases;
+
+  static GraphStats &instance() {
+    static GraphStats stats;
+    return stats;
+  };
+
+  // Times the enclosing scope as one phase
+  class Phase {
+  public:
+    Phase(const std::string &n)
+        : name(n), start(std::chrono::steady_clock::now()) {};
+    ~Phase() {
+      instance().phases.push_back(
+          {name, std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()});
+    };
+
+  private:
+    std::string name;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  void dump(std::ostream &out) const {
+    out << "{\"edgesScanned\": " << edgesScanned
+        << ", \"relaxations\": " << relaxations
+        << ", \"heapPushes\": " << heapPushes << ", \"heapPops\": " << heapPops
+        << ", \"stalePops\": " << stalePops << ", \"finds\": " << finds
+        << ", \"compressionSteps\": " << compressionSteps
+        << ", \"bytesAllocated\": " << bytesAllocated
+        << ", \"frontierSizes\": [";
+    for (size_t i = 0; i < frontierSizes.size(); i++)
+      out << (i ? ", " : "") << frontierSizes[i];
+    out << "], \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++)
+      out << (i ? ", " : "") << "{\"name\": \"" << phases[i].first
+          << "\", \"seconds\": " << phases[i].second << "}";
+    out << "]}" << std::endl;
+  };
+};
+
+#define STATS_ADD(counter, n) (GraphStats::instance().counter += (n))
+#define STATS_FRONTIER(size)                                                   \
+  GraphStats::instance().frontierSizes.push_back(size)
+#define STATS_PHASE(name) GraphStats::Phase statsPhase(name)
+#define STATS_DUMP(out) GraphStats::instance().dump(out)
+#else
+#define STATS_ADD(counter, n) ((void)0)
+#define STATS_FRONTIER(size) ((void)0)
+#define STATS_PHASE(name)
+#define STATS_DUMP(out) ((void)0)
+#endif
+
 template <class T> class Node {
 public:
   Node() : next(nullptr) {};
@@ -142,7 +218,11 @@ public:
   void insert(const T &data) {
     if (exists(data))
       return;
+    append(data);
+  };
 
+  // Append without the duplicate check, the caller guarantees uniqueness
+  void append(const T &data) {
     Node<T> *newNode = new Node<T>(data);
     if (!head)
       head = tail = newNode;
@@ -205,6 +285,7 @@ public:
   void setData(const int &d) { data = d; };
 
   void addConnectedEdge(Edge *e) { connectedEdges->insert(e); };
+  void appendConnectedEdge(Edge *e) { connectedEdges->append(e); };
   const NodeList<Edge *> *getConnectedEdges() const { return connectedEdges; };
 
   friend std::ostream &operator<<(std::ostream &out, const Vertex *v) {
@@ -275,6 +356,292 @@ private:
   std::array<Vertex *, 2> vertices;
 };
 
+class FlatAdjacency {
+  // Flat (CSR) form of getAdjacencyList: the neighbors of vertex u are
+  // targets[offsets[u]] .. targets[offsets[u + 1] - 1], vertices numbered by
+  // their position in the vertex list
+public:
+  FlatAdjacency() : offsets(1, 0) {};
+
+  // edges are (from, to, weight); transpose stores the in-neighbors instead
+  void build(int n, const std::vector<std::array<int, 3>> &edges,
+             bool transpose = false) {
+    offsets.assign(n + 1, 0);
+    outDegrees.assign(n, 0);
+    for (const auto &e : edges) {
+      offsets[(transpose ? e[1] : e[0]) + 1]++;
+      outDegrees[e[0]]++;
+    }
+    for (int u = 0; u < n; u++)
+      offsets[u + 1] += offsets[u];
+
+    targets.resize(edges.size());
+    weights.resize(edges.size());
+    std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto &e : edges) {
+      int row = transpose ? e[1] : e[0];
+      targets[fill[row]] = transpose ? e[0] : e[1];
+      weights[fill[row]++] = e[2];
+    }
+  };
+
+  int getSize() const { return (int)offsets.size() - 1; };
+  int degree(int u) const { return offsets[u + 1] - offsets[u]; };
+  int outDegree(int u) const { return outDegrees[u]; };
+  const int *neighbors(int u) const { return targets.data() + offsets[u]; };
+  const int *neighborWeights(int u) const {
+    return weights.data() + offsets[u];
+  };
+
+private:
+  std::vector<int> offsets;
+  std::vector<int> targets;
+  std::vector<int> weights;
+  std::vector<int> outDegrees;
+};
+
+template <class Real = double> class SpMVIteration {
+  // Pull-based sweeps over a FlatAdjacency: every row is written by exactly
+  // one thread, so no synchronization is needed inside a sweep
+public:
+  struct Stats {
+    int iterations;
+    Real residual;
+    std::vector<double> seconds; // time spent in each iteration
+  };
+
+  SpMVIteration(const FlatAdjacency &a, int t = 0)
+      : matrix(a),
+        threads(t > 0 ? t : std::max(1u, std::thread::hardware_concurrency())) {
+  };
+
+  // y = A x, with unit entries unless weighted
+  void multiply(const std::vector<Real> &x, std::vector<Real> &y,
+                bool weighted = true) const {
+    y.resize(matrix.getSize());
+    parallelFor([&](int u) {
+      Real sum = 0;
+      const int *v = matrix.neighbors(u);
+      const int *w = matrix.neighborWeights(u);
+      for (int i = 0; i < matrix.degree(u); i++)
+        sum += (weighted ? (Real)w[i] : (Real)1) * x[v[i]];
+      y[u] = sum;
+    });
+  };
+
+  // The matrix must hold in-neighbors (built with transpose). Dangling
+  // vertices spread their rank uniformly. Stops once the L1 change of an
+  // iteration drops below tolerance.
+  Stats pageRank(std::vector<Real> &rank, Real damping = 0.85,
+                 Real tolerance = 1e-6, int maxIterations = 100) const {
+    int n = matrix.getSize();
+    Stats stats = {0, 0, {}};
+    if (n == 0)
+      return stats;
+
+    std::vector<Real> contribution(n), next(n);
+    rank.assign(n, (Real)1 / n);
+
+    for (stats.iterations = 0; stats.iterations < maxIterations;) {
+      auto start = std::chrono::steady_clock::now();
+
+      Real dangling = 0;
+      for (int u = 0; u < n; u++) {
+        if (matrix.outDegree(u) > 0)
+          contribution[u] = rank[u] / matrix.outDegree(u);
+        else {
+          contribution[u] = 0;
+          dangling += rank[u];
+        }
+      }
+
+      Real base = (1 - damping) / n + damping * dangling / n;
+      parallelFor([&](int u) {
+        Real sum = 0;
+        const int *v = matrix.neighbors(u);
+        for (int i = 0; i < matrix.degree(u); i++)
+          sum += contribution[v[i]];
+        next[u] = base + damping * sum;
+      });
+
+      stats.residual = 0;
+      for (int u = 0; u < n; u++)
+        stats.residual += std::fabs(next[u] - rank[u]);
+      rank.swap(next);
+      stats.iterations++;
+
+      stats.seconds.push_back(std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count());
+      if (stats.residual < tolerance)
+        break;
+    }
+
+    return stats;
+  };
+
+private:
+  const FlatAdjacency &matrix;
+  int threads;
+
+  // Rows split into one contiguous range per thread
+  template <class F> void parallelFor(F row) const {
+    int n = matrix.getSize();
+    int step = (n + threads - 1) / threads;
+    std::vector<std::thread> pool;
+    for (int first = step; first < n; first += step)
+      pool.emplace_back([&row, first, step, n]() {
+        for (int u = first; u < std::min(first + step, n); u++)
+          row(u);
+      });
+    for (int u = 0; u < std::min(step, n); u++)
+      row(u);
+    for (auto &t : pool)
+      t.join();
+  };
+};
+
+class DisjointSets {
+  // Union-find over 0 .. n - 1 with union by rank and path halving
+public:
+  DisjointSets(int n) : parent(n), rank(n, 0) {
+    for (int i = 0; i < n; i++)
+      parent[i] = i;
+  };
+
+  int find(int x) {
+    STATS_ADD(finds, 1);
+    while (parent[x] != x) {
+      STATS_ADD(compressionSteps, 1);
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+    return x;
+  };
+
+  // Does not compress, so several threads may call it between unions
+  int root(int x) const {
+    while (parent[x] != x)
+      x = parent[x];
+    return x;
+  };
+
+  // false when x and y already were in the same set
+  bool unite(int x, int y) {
+    x = find(x);
+    y = find(y);
+    if (x == y)
+      return false;
+    if (rank[x] < rank[y])
+      std::swap(x, y);
+    parent[y] = x;
+    if (rank[x] == rank[y])
+      rank[x]++;
+    return true;
+  };
+
+private:
+  std::vector<int> parent;
+  std::vector<int> rank;
+};
+
+class FilterKruskal {
+  // Minimum spanning forest by Filter-Kruskal: the edges are split around a
+  // pivot weight, the light side is solved first, and heavy edges that are
+  // already inside one component are dropped before they are ever sorted.
+  // Splitting and filtering run on several threads.
+public:
+  struct IndexedEdge {
+    int weight;
+    int u;
+    int v;
+    int id;
+  };
+
+  FilterKruskal(int n, int t = 0)
+      : sets(n),
+        threads(t > 0 ? t : std::max(1u, std::thread::hardware_concurrency())) {
+  };
+
+  // Ids of the forest edges, in the order they were taken
+  void run(std::vector<IndexedEdge> edges, std::vector<int> &forest) {
+    forest.clear();
+    solve(edges, forest);
+  };
+
+private:
+  static const size_t BASE_SIZE = 1 << 10; // plain Kruskal below this
+
+  DisjointSets sets;
+  int threads;
+
+  void kruskal(std::vector<IndexedEdge> &edges, std::vector<int> &forest) {
+    std::sort(edges.begin(), edges.end(),
+              [](const IndexedEdge &a, const IndexedEdge &b) {
+                return a.weight < b.weight;
+              });
+    for (const IndexedEdge &e : edges) {
+      STATS_ADD(edgesScanned, 1);
+      if (sets.unite(e.u, e.v))
+        forest.push_back(e.id);
+    }
+  };
+
+  void solve(std::vector<IndexedEdge> &edges, std::vector<int> &forest) {
+    if (edges.size() <= BASE_SIZE) {
+      kruskal(edges, forest);
+      return;
+    }
+
+    int a = edges.front().weight, b = edges[edges.size() / 2].weight,
+        c = edges.back().weight;
+    int pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+    std::vector<IndexedEdge> light, heavy;
+    split(
+        edges, [pivot](const IndexedEdge &e) { return e.weight <= pivot; },
+        light, heavy);
+    std::vector<IndexedEdge>().swap(edges);
+    if (heavy.empty()) { // every weight is at most the pivot
+      kruskal(light, forest);
+      return;
+    }
+    solve(light, forest);
+
+    std::vector<IndexedEdge> crossing, inside;
+    split(
+        heavy,
+        [this](const IndexedEdge &e) {
+          return sets.root(e.u) != sets.root(e.v);
+        },
+        crossing, inside);
+    solve(crossing, forest);
+  };
+
+  // Stable partition, every thread takes one contiguous chunk
+  template <class Pred>
+  void split(const std::vector<IndexedEdge> &edges, Pred pred,
+             std::vector<IndexedEdge> &yes, std::vector<IndexedEdge> &no) {
+    int t = (int)std::min<size_t>(threads, edges.size() / BASE_SIZE + 1);
+    size_t chunk = (edges.size() + t - 1) / t;
+    std::vector<std::vector<IndexedEdge>> yesParts(t), noParts(t);
+    std::vector<std::thread> pool;
+    for (int i = 0; i < t; i++)
+      pool.emplace_back([&, i] {
+        size_t end = std::min(edges.size(), (i + 1) * chunk);
+        for (size_t j = i * chunk; j < end; j++)
+          (pred(edges[j]) ? yesParts[i] : noParts[i]).push_back(edges[j]);
+      });
+    for (auto &th : pool)
+      th.join();
+
+    for (int i = 0; i < t; i++) {
+      yes.insert(yes.end(), yesParts[i].begin(), yesParts[i].end());
+      no.insert(no.end(), noParts[i].begin(), noParts[i].end());
+    }
+  };
+};
+
 class Graph {
 public:
   Graph()
@@ -282,19 +649,7 @@ public:
         edgeList(new NodeList<Edge *>()) {};
   Graph(const Graph &g)
       : vertexList(new NodeList<Vertex *>()), edgeList(new NodeList<Edge *>()) {
-    Node<Vertex *> *curVertex = g.getVertexList()->getHead();
-    while (curVertex) {
-      insertVertex(curVertex->getData()->getData());
-      curVertex = curVertex->getNext();
-    }
-
-    Node<Edge *> *curEdge = g.getEdgeList()->getHead();
-    while (curEdge) {
-      insertEdge((*curEdge->getData())[0]->getData(),
-                 (*curEdge->getData())[1]->getData(),
-                 curEdge->getData()->getWeight());
-      curEdge = curEdge->getNext();
-    }
+    copyFrom(g, nullptr, [](const Edge *) { return true; });
   };
 
   ~Graph() {
@@ -377,6 +732,29 @@ public:
     }
   };
 
+  void getFlatAdjacency(FlatAdjacency &adj, bool transpose = false) const {
+    std::unordered_map<Vertex *, int> index;
+    std::vector<std::array<int, 3>> edges;
+    Node<Vertex *> *v = vertexList->getHead();
+    for (int i = 0; v; i++, v = v->getNext())
+      index[v->getData()] = i;
+
+    Node<Edge *> *e = nullptr;
+    Vertex *otherEnd = nullptr;
+    v = vertexList->getHead();
+    while (v) {
+      e = v->getData()->getConnectedEdges()->getHead();
+      while (e) {
+        otherEnd = e->getData()->getAnotherEnd(v->getData());
+        edges.push_back({index[v->getData()], index[otherEnd],
+                         e->getData()->getWeight()});
+        e = e->getNext();
+      }
+      v = v->getNext();
+    }
+    adj.build(vertexList->getSize(), edges, transpose);
+  };
+
   bool isLinked(const Edge *otherEdge) const {
     if (otherEdge) {
       Node<Edge *> *e = getEdgeList()->getHead();
@@ -413,12 +791,96 @@ public:
   NodeList<Vertex *> *getVertexList() const { return vertexList; };
   NodeList<Edge *> *getEdgeList() const { return edgeList; };
 
-  void minimumCostSpanningTree() const;
+  // Subgraph induced by the given vertex values, sub is expected to be empty
+  void getInducedSubgraph(const std::unordered_set<int> &vertices,
+                          Graph &sub) const {
+    sub.copyFrom(*this, &vertices, [](const Edge *) { return true; });
+  };
+
+  // Subgraph of the edges accepted by keepEdge, with all the vertices
+  template <class Keep> void getEdgeSubgraph(Keep keepEdge, Graph &sub) const {
+    sub.copyFrom(*this, nullptr, keepEdge);
+  };
+
+  // Minimum spanning forest: one tree for every connected component
+  void minimumSpanningForest(std::vector<Edge *> &forest,
+                             int threads = 0) const {
+    std::unordered_map<const Vertex *, int> index;
+    Node<Vertex *> *v = vertexList->getHead();
+    for (int i = 0; v; i++, v = v->getNext())
+      index[v->getData()] = i;
+
+    std::vector<Edge *> byId;
+    std::vector<FilterKruskal::IndexedEdge> edges;
+    Node<Edge *> *e = edgeList->getHead();
+    for (int id = 0; e; id++, e = e->getNext()) {
+      Edge *edge = e->getData();
+      byId.push_back(edge);
+      edges.push_back(
+          {edge->getWeight(), index[(*edge)[0]], index[(*edge)[1]], id});
+    }
+
+    std::vector<int> ids;
+    FilterKruskal(vertexList->getSize(), threads).run(std::move(edges), ids);
+    forest.clear();
+    for (int id : ids)
+      forest.push_back(byId[id]);
+  };
+
+  // forest uses minimumSpanningForest, so disconnected graphs keep every
+  // component
+  void minimumCostSpanningTree(bool forest = false) const;
 
 private:
   NodeList<Vertex *> *vertexList;
   NodeList<Edge *> *edgeList;
 
+  // O(V + E) copy: old vertices and edges are mapped to their copies, which
+  // are appended directly instead of going through insertVertex/insertEdge
+  template <class Keep>
+  void copyFrom(const Graph &g, const std::unordered_set<int> *vertices,
+                Keep keepEdge) {
+    std::unordered_map<const Vertex *, Vertex *> vertexMap;
+    std::unordered_map<const Edge *, Edge *> edgeMap;
+
+    Node<Vertex *> *curVertex = g.getVertexList()->getHead();
+    while (curVertex) {
+      Vertex *v = curVertex->getData();
+      if (!vertices || vertices->count(v->getData())) {
+        vertexMap[v] = new Vertex(v->getData());
+        vertexList->append(vertexMap[v]);
+      }
+      curVertex = curVertex->getNext();
+    }
+
+    Node<Edge *> *curEdge = g.getEdgeList()->getHead();
+    while (curEdge) {
+      Edge *e = curEdge->getData();
+      auto u = vertexMap.find((*e)[0]), v = vertexMap.find((*e)[1]);
+      if (u != vertexMap.end() && v != vertexMap.end() && keepEdge(e)) {
+        edgeMap[e] = new Edge(u->second, v->second, e->getWeight());
+        edgeList->append(edgeMap[e]);
+      }
+      curEdge = curEdge->getNext();
+    }
+
+    // Keep every vertex's adjacency in the original order
+    curVertex = g.getVertexList()->getHead();
+    while (curVertex) {
+      auto v = vertexMap.find(curVertex->getData());
+      if (v != vertexMap.end()) {
+        curEdge = curVertex->getData()->getConnectedEdges()->getHead();
+        while (curEdge) {
+          auto e = edgeMap.find(curEdge->getData());
+          if (e != edgeMap.end())
+            v->second->appendConnectedEdge(e->second);
+          curEdge = curEdge->getNext();
+        }
+      }
+      curVertex = curVertex->getNext();
+    }
+  };
+
   bool hasCycle() const {
     std::unordered_map<Vertex *, bool> visited;
 
@@ -449,6 +911,7 @@ private:
 
     Node<Edge *> *curEdge = vertex->getConnectedEdges()->getHead();
     while (curEdge) {
+      STATS_ADD(edgesScanned, 1);
       Vertex *neighbor = curEdge->getData()->getAnotherEnd(vertex);
 
       // If the neighbor is not visited, recurse on it
@@ -467,8 +930,19 @@ private:
   }
 };
 
-void Graph::minimumCostSpanningTree() const {
+void Graph::minimumCostSpanningTree(bool forest) const {
   // Using Prim's algorithm and adjacent list
+  STATS_PHASE("minimumCostSpanningTree");
+  if (forest) {
+    std::vector<Edge *> edges;
+    minimumSpanningForest(edges);
+    std::sort(edges.begin(), edges.end(),
+              [](Edge *a, Edge *b) { return *a < *b; });
+    for (auto &e : edges)
+      std::cout << e << std::endl;
+    return;
+  }
+
   Graph minSpanTree;
   Graph *tmpSpanTree;
   Node<Vertex *> *curVertex;
@@ -512,6 +986,7 @@ void Graph::minimumCostSpanningTree() const {
         // Find the minEdge that is connected to the minSpanTree with the
         // adjacency list
         for (const auto &adjVertex : curAdjList) {
+          STATS_ADD(edgesScanned, 1);
           tmpEdge =
               getEdge(curVertex->getData()->getData(), adjVertex->getData());
           if (!visitedEdges[tmpEdge] && minSpanTree.isLinked(tmpEdge)) {
@@ -559,6 +1034,7 @@ void Graph::minimumCostSpanningTree() const {
       minWeight = INT_MAX;
       minEdge = nullptr;
       while (curEdge) {
+        STATS_ADD(edgesScanned, 1);
         if (!visitedEdges[curEdge->getData()]) {
           if ((!minSpanTree.isLinked(minEdge) &&
                (minSpanTree.isLinked(curEdge->getData()) ||
@@ -613,6 +1089,7 @@ int main() {
 
   g.minimumCostSpanningTree();
 
+  STATS_DUMP(std::cerr);
   return 0;
 }
 
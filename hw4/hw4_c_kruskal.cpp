@@ -7,6 +7,7 @@
 #include <stack>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 inline void print(std::string s) { std::cout << s << std::endl; }
@@ -142,7 +143,11 @@ public:
   void insert(const T &data) {
     if (exists(data))
       return;
+    append(data);
+  };
 
+  // Append without the duplicate check, the caller guarantees uniqueness
+  void append(const T &data) {
     Node<T> *newNode = new Node<T>(data);
     if (!head)
       head = tail = newNode;
@@ -205,6 +210,7 @@ public:
   void setData(const int &d) { data = d; };
 
   void addConnectedEdge(Edge *e) { connectedEdges->insert(e); };
+  void appendConnectedEdge(Edge *e) { connectedEdges->append(e); };
   const NodeList<Edge *> *getConnectedEdges() const { return connectedEdges; };
 
   friend std::ostream &operator<<(std::ostream &out, const Vertex *v) {
@@ -282,19 +288,7 @@ public:
         edgeList(new NodeList<Edge *>()) {};
   Graph(const Graph &g)
       : vertexList(new NodeList<Vertex *>()), edgeList(new NodeList<Edge *>()) {
-    Node<Vertex *> *curVertex = g.getVertexList()->getHead();
-    while (curVertex) {
-      insertVertex(curVertex->getData()->getData());
-      curVertex = curVertex->getNext();
-    }
-
-    Node<Edge *> *curEdge = g.getEdgeList()->getHead();
-    while (curEdge) {
-      insertEdge((*curEdge->getData())[0]->getData(),
-                 (*curEdge->getData())[1]->getData(),
-                 curEdge->getData()->getWeight());
-      curEdge = curEdge->getNext();
-    }
+    copyFrom(g, nullptr, [](const Edge *) { return true; });
   };
 
   ~Graph() {
@@ -410,12 +404,69 @@ public:
   NodeList<Vertex *> *getVertexList() const { return vertexList; };
   NodeList<Edge *> *getEdgeList() const { return edgeList; };
 
+  // Subgraph induced by the given vertex values, sub is expected to be empty
+  void getInducedSubgraph(const std::unordered_set<int> &vertices,
+                          Graph &sub) const {
+    sub.copyFrom(*this, &vertices, [](const Edge *) { return true; });
+  };
+
+  // Subgraph of the edges accepted by keepEdge, with all the vertices
+  template <class Keep> void getEdgeSubgraph(Keep keepEdge, Graph &sub) const {
+    sub.copyFrom(*this, nullptr, keepEdge);
+  };
+
   void minimumCostSpanningTree() const;
 
 private:
   NodeList<Vertex *> *vertexList;
   NodeList<Edge *> *edgeList;
 
+  // O(V + E) copy: old vertices and edges are mapped to their copies, which
+  // are appended directly instead of going through insertVertex/insertEdge
+  template <class Keep>
+  void copyFrom(const Graph &g, const std::unordered_set<int> *vertices,
+                Keep keepEdge) {
+    std::unordered_map<const Vertex *, Vertex *> vertexMap;
+    std::unordered_map<const Edge *, Edge *> edgeMap;
+
+    Node<Vertex *> *curVertex = g.getVertexList()->getHead();
+    while (curVertex) {
+      Vertex *v = curVertex->getData();
+      if (!vertices || vertices->count(v->getData())) {
+        vertexMap[v] = new Vertex(v->getData());
+        vertexList->append(vertexMap[v]);
+      }
+      curVertex = curVertex->getNext();
+    }
+
+    Node<Edge *> *curEdge = g.getEdgeList()->getHead();
+    while (curEdge) {
+      Edge *e = curEdge->getData();
+      auto u = vertexMap.find((*e)[0]), v = vertexMap.find((*e)[1]);
+      if (u != vertexMap.end() && v != vertexMap.end() && keepEdge(e)) {
+        edgeMap[e] = new Edge(u->second, v->second, e->getWeight());
+        edgeList->append(edgeMap[e]);
+      }
+      curEdge = curEdge->getNext();
+    }
+
+    // Keep every vertex's adjacency in the original order
+    curVertex = g.getVertexList()->getHead();
+    while (curVertex) {
+      auto v = vertexMap.find(curVertex->getData());
+      if (v != vertexMap.end()) {
+        curEdge = curVertex->getData()->getConnectedEdges()->getHead();
+        while (curEdge) {
+          auto e = edgeMap.find(curEdge->getData());
+          if (e != edgeMap.end())
+            v->second->appendConnectedEdge(e->second);
+          curEdge = curEdge->getNext();
+        }
+      }
+      curVertex = curVertex->getNext();
+    }
+  };
+
   bool hasCycle() const {
     std::unordered_map<Vertex *, bool> visited;
 
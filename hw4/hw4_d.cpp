@@ -1,16 +1,105 @@
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
 #include <climits>
+#include <condition_variable>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <queue>
+#include <set>
 #include <stack>
 #include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <type_traits>
+#include <unistd.h>
 #include <unordered_map>
 #include <vector>
 
 inline void print(std::string s) { std::cout << s << std::endl; }
 
+// Instrumentation counters, compiled in with -DGRAPH_STATS. Without it every
+// STATS_* macro expands to nothing, so the engines pay no cost at all. The
+// counters are atomic because kShortestPaths runs its spur searches on
+// several threads.
+#ifdef GRAPH_STATS
+#include <atomic>
+#include <chrono>
+
+class GraphStats {
+public:
+  std::atomic<long long> edgesScanned = 0;
+  std::atomic<long long> relaxations = 0;
+  std::atomic<long long> heapPushes = 0;
+  std::atomic<long long> heapPops = 0;
+  // Lazy deletion stands in for decrease-key, stale pops measure its cost
+  std::atomic<long long> stalePops = 0;
+  std::atomic<long long> finds = 0;
+  std::atomic<long long> compressionSteps = 0;
+  std::atomic<long long> bytesAllocated = 0;
+  std::vector<long long> frontierSizes;
+  std::vector<std::pair<std::string, double>> phases;
+
+  static GraphStats &instance() {
+    static GraphStats stats;
+    return stats;
+  };
+
+  // Times the enclosing scope as one phase
+  class Phase {
+  public:
+    Phase(const std::string &n)
+        : name(n), start(std::chrono::steady_clock::now()) {};
+    ~Phase() {
+      instance().phases.push_back(
+          {name, std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()});
+    };
+
+  private:
+    std::string name;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  void dump(std::ostream &out) const {
+    out << "{\"edgesScanned\": " << edgesScanned
+        << ", \"relaxations\": " << relaxations
+        << ", \"heapPushes\": " << heapPushes << ", \"heapPops\": " << heapPops
+        << ", \"stalePops\": " << stalePops << ", \"finds\": " << finds
+        << ", \"compressionSteps\": " << compressionSteps
+        << ", \"bytesAllocated\": " << bytesAllocated
+        << ", \"frontierSizes\": [";
+    for (size_t i = 0; i < frontierSizes.size(); i++)
+      out << (i ? ", " : "") << frontierSizes[i];
+    out << "], \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++)
+      out << (i ? ", " : "") << "{\"name\": \"" << phases[i].first
+          << "\", \"seconds\": " << phases[i].second << "}";
+    out << "]}" << std::endl;
+  };
+};
+
+#define STATS_ADD(counter, n) (GraphStats::instance().counter += (n))
+#define STATS_FRONTIER(size)                                                   \
+  GraphStats::instance().frontierSizes.push_back(size)
+#define STATS_PHASE(name) GraphStats::Phase statsPhase(name)
+#define STATS_DUMP(out) GraphStats::instance().dump(out)
+#else
+#define STATS_ADD(counter, n) ((void)0)
+#define STATS_FRONTIER(size) ((void)0)
+#define STATS_PHASE(name)
+#define STATS_DUMP(out) ((void)0)
+#endif
+
 template <class T> class Node {
 public:
   Node() : next(nullptr) {};
@@ -183,13 +272,65 @@ private:
   };
 };
 
-class Vertex;
-class Edge;
+template <class W> struct WeightTraits {
+  using Weight = W;
+  using Distance = W;
+  static constexpr bool weighted = true;
+
+  static constexpr Distance infinity() {
+    return std::numeric_limits<W>::has_infinity
+               ? std::numeric_limits<W>::infinity()
+               : std::numeric_limits<W>::max();
+  };
+
+  // False when the sum does not fit, the caller then treats it as infinity
+  static bool add(const Distance &d, const Weight &w, Distance &sum) {
+    if constexpr (std::is_integral<W>::value)
+      return !__builtin_add_overflow(d, w, &sum) && sum != infinity();
+    else {
+      sum = d + w;
+      return sum < infinity();
+    }
+  };
+};
+
+// Unweighted graphs: every edge counts as 1 and no weight is stored
+template <> struct WeightTraits<void> {
+  using Weight = int;
+  using Distance = int;
+  static constexpr bool weighted = false;
+
+  static constexpr Distance infinity() { return INT_MAX; };
+  static bool add(const Distance &d, const Weight &w, Distance &sum) {
+    return WeightTraits<int>::add(d, w, sum);
+  };
+};
+
+template <class W> class EdgeWeight {
+public:
+  EdgeWeight(const W &w) : weight(w) {};
+  W getWeight() const { return weight; };
+
+private:
+  W weight;
+};
 
-class Vertex {
+template <> class EdgeWeight<void> {
 public:
-  Vertex(int d) : data(d), connectedEdges(new NodeList<Edge *>()) {};
-  ~Vertex() { delete connectedEdges; };
+  EdgeWeight(const int &) {};
+  int getWeight() const { return 1; };
+};
+
+template <class W> class BasicVertex;
+template <class W> class BasicEdge;
+
+template <class W> class BasicVertex {
+  using Vertex = BasicVertex<W>;
+  using Edge = BasicEdge<W>;
+
+public:
+  BasicVertex(int d) : data(d), connectedEdges(new NodeList<Edge *>()) {};
+  ~BasicVertex() { delete connectedEdges; };
   bool operator==(const Vertex *other) const {
     return other && data == other->getData();
   };
@@ -218,10 +359,16 @@ private:
   NodeList<Edge *> *connectedEdges;
 };
 
-class Edge {
+template <class W> class BasicEdge : private EdgeWeight<W> {
+  using Vertex = BasicVertex<W>;
+  using Edge = BasicEdge<W>;
+
 public:
-  Edge(Vertex *u, Vertex *v, int w = 1) : weight(w), vertices({u, v}) {};
-  ~Edge() {};
+  using Weight = typename WeightTraits<W>::Weight;
+
+  BasicEdge(Vertex *u, Vertex *v, const Weight &w = 1)
+      : EdgeWeight<W>(w), vertices({u, v}) {};
+  ~BasicEdge() {};
   bool operator==(const Edge *other) const {
     return (getWeight() == other->getWeight() &&
             ((vertices[0] == other->vertices[0] &&
@@ -244,7 +391,7 @@ public:
              *(vertices[1]) < *(other.vertices[1])) ||
             (*(vertices[0]) == *(other.vertices[0]) &&
              *(vertices[1]) == *(other.vertices[1]) &&
-             weight < other.getWeight()));
+             getWeight() < other.getWeight()));
   };
 
   bool operator!=(const Edge &other) const { return !(*this == other); };
@@ -257,7 +404,7 @@ public:
     return (v == vertices[0]) ? vertices[1] : vertices[0];
   };
 
-  int getWeight() const { return weight; };
+  Weight getWeight() const { return EdgeWeight<W>::getWeight(); };
 
   friend std::ostream &operator<<(std::ostream &out, const Edge *e) {
     if (e)
@@ -271,16 +418,551 @@ public:
   };
 
 private:
-  int weight;
   std::array<Vertex *, 2> vertices;
 };
 
-class Graph {
+// Out-edges of vertex u are the slots offsets[u] .. offsets[u + 1] - 1,
+// vertices numbered by their position in the vertex list
+template <class W> struct IndexedAdjacency {
+  std::vector<int> offsets;
+  std::vector<int> targets;
+  std::vector<typename WeightTraits<W>::Weight> weights;
+
+  int getSize() const { return (int)offsets.size() - 1; };
+};
+
+template <class W> class DijkstraWorkspace {
+  // Query state kept across calls. An entry is only valid when its stamp
+  // matches the current query version, so starting a query is O(1) and the
+  // work of a query is proportional to the region it explores. The
+  // adjacency must outlive the workspace and not change while it is used.
+  using Traits = WeightTraits<W>;
+
 public:
-  Graph()
+  using Distance = typename Traits::Distance;
+
+  DijkstraWorkspace(const IndexedAdjacency<W> &a)
+      : adj(a), dist(a.getSize()), predEdge(a.getSize()),
+        predVertex(a.getSize()), stamp(a.getSize(), 0), version(0) {
+    STATS_ADD(bytesAllocated,
+              (long long)a.getSize() *
+                  (sizeof(Distance) + 2 * sizeof(int) + sizeof(unsigned)));
+  };
+
+  // Shortest distances from source; stops once target is settled (-1: never)
+  void run(int source, int target = -1) {
+    if (++version == 0) {
+      std::fill(stamp.begin(), stamp.end(), 0);
+      version = 1;
+    }
+    heap.clear();
+    settle(source, 0, -1, -1);
+
+    // Unit weights: a FIFO queue settles vertices in distance order
+    if constexpr (!Traits::weighted) {
+      heap.push_back({0, source});
+      for (size_t head = 0; head < heap.size(); head++) {
+        int u = heap[head].second;
+        if (u == target)
+          break;
+        for (int i = adj.offsets[u]; i < adj.offsets[u + 1]; i++) {
+          int v = adj.targets[i];
+          STATS_ADD(edgesScanned, 1);
+          if (!isBanned(i, v) && !reached(v)) {
+            settle(v, dist[u] + 1, i, u);
+            heap.push_back({dist[v], v});
+            STATS_ADD(relaxations, 1);
+          }
+        }
+      }
+      return;
+    }
+
+    auto later = [](const std::pair<Distance, int> &a,
+                    const std::pair<Distance, int> &b) {
+      return a.first > b.first;
+    };
+    heap.push_back({0, source});
+    STATS_ADD(heapPushes, 1);
+    while (!heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), later);
+      auto [curDist, u] = heap.back();
+      heap.pop_back();
+      STATS_ADD(heapPops, 1);
+      if (curDist > dist[u]) {
+        STATS_ADD(stalePops, 1);
+        continue;
+      }
+      if (u == target)
+        break;
+
+      for (int i = adj.offsets[u]; i < adj.offsets[u + 1]; i++) {
+        int v = adj.targets[i];
+        Distance newDist;
+        STATS_ADD(edgesScanned, 1);
+        // A sum that overflows the distance type never counts as shorter
+        if (isBanned(i, v) || !Traits::add(curDist, adj.weights[i], newDist) ||
+            (reached(v) && newDist >= dist[v]))
+          continue;
+        settle(v, newDist, i, u);
+        heap.push_back({newDist, v});
+        std::push_heap(heap.begin(), heap.end(), later);
+        STATS_ADD(relaxations, 1);
+        STATS_ADD(heapPushes, 1);
+      }
+    }
+  };
+
+  bool reached(int v) const { return stamp[v] == version; };
+  Distance getDistance(int v) const {
+    return reached(v) ? dist[v] : Traits::infinity();
+  };
+  int getPredecessor(int v) const { return reached(v) ? predVertex[v] : -1; };
+
+  // Path of the last query to target, edges as adjacency slots
+  bool getPath(int target, std::vector<int> &vertices,
+               std::vector<int> *edges = nullptr) const {
+    vertices.clear();
+    if (edges)
+      edges->clear();
+    if (!reached(target))
+      return false;
+
+    for (int v = target; v != -1; v = predVertex[v]) {
+      vertices.push_back(v);
+      if (edges && predEdge[v] != -1)
+        edges->push_back(predEdge[v]);
+    }
+    std::reverse(vertices.begin(), vertices.end());
+    if (edges)
+      std::reverse(edges->begin(), edges->end());
+    return true;
+  };
+
+  // Banned vertices and edge slots are skipped by the following queries
+  void banVertex(int v, bool banned = true) {
+    if (bannedVertex.empty())
+      bannedVertex.assign(adj.getSize(), 0);
+    bannedVertex[v] = banned;
+  };
+  void banEdge(int slot, bool banned = true) {
+    if (bannedEdge.empty())
+      bannedEdge.assign(adj.targets.size(), 0);
+    bannedEdge[slot] = banned;
+  };
+
+private:
+  const IndexedAdjacency<W> &adj;
+  std::vector<Distance> dist;
+  std::vector<int> predEdge;
+  std::vector<int> predVertex;
+  std::vector<unsigned> stamp;
+  unsigned version;
+  std::vector<std::pair<Distance, int>> heap;
+  std::vector<char> bannedVertex;
+  std::vector<char> bannedEdge;
+
+  void settle(int v, const Distance &d, int edge, int from) {
+    stamp[v] = version;
+    dist[v] = d;
+    predEdge[v] = edge;
+    predVertex[v] = from;
+  };
+
+  bool isBanned(int slot, int v) const {
+    return (!bannedEdge.empty() && bannedEdge[slot]) ||
+           (!bannedVertex.empty() && bannedVertex[v]);
+  };
+};
+
+template <class W> class ConcurrentGraph {
+  // Readers traverse an immutable Snapshot: the compacted base adjacency plus
+  // the edges added since, in immutable segments sorted by source that
+  // snapshots share. Writers serialize on a mutex, build the next snapshot
+  // and publish it with one atomic pointer exchange, so readers never lock.
+  // A replaced snapshot is freed once every active reader announced a later
+  // epoch (epoch-based reclamation). When the delta grows past the threshold
+  // it is merged into a new base adjacency.
+  using Traits = WeightTraits<W>;
+
+public:
+  using Weight = typename Traits::Weight;
+  using Distance = typename Traits::Distance;
+
+  struct DeltaEdge {
+    int from;
+    int to;
+    Weight weight;
+  };
+
+  // Sorted by source, insertion order kept among the edges of one source
+  using Segment = std::shared_ptr<const std::vector<DeltaEdge>>;
+
+  class Snapshot {
+  public:
+    Snapshot(std::shared_ptr<const IndexedAdjacency<W>> b,
+             std::vector<Segment> d, int n)
+        : base(std::move(b)), delta(std::move(d)), vertexCount(n) {};
+
+    int getSize() const { return vertexCount; };
+
+    // visit(v, weight) for every out-edge of u
+    template <class F> void forEachNeighbor(int u, F visit) const {
+      if (u < base->getSize())
+        for (int i = base->offsets[u]; i < base->offsets[u + 1]; i++)
+          visit(base->targets[i], base->weights[i]);
+
+      // Older segments first, so edges come in insertion order
+      for (const Segment &segment : delta) {
+        auto first = std::lower_bound(
+            segment->begin(), segment->end(), u,
+            [](const DeltaEdge &e, int from) { return e.from < from; });
+        for (; first != segment->end() && first->from == u; ++first)
+          visit(first->to, first->weight);
+      }
+    };
+
+    // Level of every vertex from source, -1 when unreachable (all of them
+    // when source is not a vertex)
+    void BFS(int source, std::vector<int> &level) const {
+      level.assign(vertexCount, -1);
+      if (source < 0 || source >= vertexCount)
+        return;
+      std::vector<int> queue = {source};
+      level[source] = 0;
+      for (size_t head = 0; head < queue.size(); head++) {
+        int u = queue[head];
+        forEachNeighbor(u, [&](int v, const Weight &) {
+          if (level[v] == -1) {
+            level[v] = level[u] + 1;
+            queue.push_back(v);
+          }
+        });
+      }
+    };
+
+    void shortestDistances(int source, std::vector<Distance> &dist) const {
+      auto later = [](const std::pair<Distance, int> &a,
+                      const std::pair<Distance, int> &b) {
+        return a.first > b.first;
+      };
+      dist.assign(vertexCount, Traits::infinity());
+      if (source < 0 || source >= vertexCount)
+        return;
+      std::vector<std::pair<Distance, int>> heap = {{0, source}};
+      dist[source] = 0;
+
+      while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        auto [curDist, u] = heap.back();
+        heap.pop_back();
+        if (curDist > dist[u])
+          continue;
+
+        forEachNeighbor(u, [&](int v, const Weight &w) {
+          Distance newDist;
+          if (Traits::add(curDist, w, newDist) && newDist < dist[v]) {
+            dist[v] = newDist;
+            heap.push_back({newDist, v});
+            std::push_heap(heap.begin(), heap.end(), later);
+          }
+        });
+      }
+    };
+
+  private:
+    friend class ConcurrentGraph;
+    std::shared_ptr<const IndexedAdjacency<W>> base;
+    std::vector<Segment> delta; // oldest first
+    int vertexCount;
+  };
+
+  // One per reader thread: claims an epoch slot for its whole lifetime,
+  // waiting for another Reader to go away when all of them are taken
+  class Reader {
+  public:
+    Reader(ConcurrentGraph &g) : graph(g), slot(-1), snapshot(nullptr) {
+      std::unique_lock<std::mutex> lock(graph.slotLock);
+      graph.slotFreed.wait(lock, [this] {
+        for (int i = 0; i < MAX_READERS && slot == -1; i++)
+          if (!graph.slotUsed[i])
+            slot = i;
+        return slot != -1;
+      });
+      graph.slotUsed[slot] = true;
+    };
+    ~Reader() {
+      exit();
+      {
+        std::lock_guard<std::mutex> lock(graph.slotLock);
+        graph.slotUsed[slot] = false;
+      }
+      graph.slotFreed.notify_one();
+    };
+
+    // The snapshot stays valid until exit()
+    const Snapshot &enter() {
+      graph.announced[slot].store(graph.epoch.load());
+      snapshot = graph.current.load();
+      return *snapshot;
+    };
+    void exit() {
+      snapshot = nullptr;
+      graph.announced[slot].store(0);
+    };
+
+  private:
+    ConcurrentGraph &graph;
+    int slot;
+    const Snapshot *snapshot;
+  };
+
+  ConcurrentGraph(const IndexedAdjacency<W> &adj = IndexedAdjacency<W>(),
+                  size_t threshold = 1 << 16)
+      : compactThreshold(threshold), epoch(1) {
+    auto base = std::make_shared<IndexedAdjacency<W>>(adj);
+    if (base->offsets.empty())
+      base->offsets.push_back(0);
+    current.store(new Snapshot(base, std::vector<Segment>(), base->getSize()));
+    for (int i = 0; i < MAX_READERS; i++) {
+      slotUsed[i] = false;
+      announced[i].store(0);
+    }
+  };
+
+  // No reader may be active any more
+  ~ConcurrentGraph() {
+    delete current.load();
+    for (auto &r : retired)
+      delete r.first;
+  };
+
+  // The new vertex gets the next index, which is returned
+  int insertVertex() {
+    std::lock_guard<std::mutex> lock(writer);
+    const Snapshot *s = current.load();
+    int v = s->vertexCount;
+    publish(new Snapshot(s->base, s->delta, v + 1));
+    return v;
+  };
+
+  void insertEdge(int u, int v, const Weight &w = 1) {
+    insertEdges({{u, v, w}});
+  };
+
+  // One publication for the whole batch. Ids must be in [0, getSize()),
+  // other edges are reported and dropped.
+  void insertEdges(const std::vector<DeltaEdge> &edges) {
+    std::lock_guard<std::mutex> lock(writer);
+    const Snapshot *s = current.load();
+    std::vector<DeltaEdge> batch;
+    batch.reserve(edges.size());
+    for (const DeltaEdge &e : edges) {
+      if (e.from < 0 || e.from >= s->vertexCount || e.to < 0 ||
+          e.to >= s->vertexCount) {
+        std::cerr << "Vertex out of range for concurrent graph: " << e.from
+                  << " " << e.to << std::endl;
+        continue;
+      }
+      batch.push_back(e);
+    }
+    if (batch.empty())
+      return;
+    std::stable_sort(batch.begin(), batch.end(), bySource);
+
+    // Newer segments at most as large as the batch are merged into it, so
+    // there are O(log delta) segments and each edge is copied O(log) times
+    std::vector<Segment> delta = s->delta;
+    size_t deltaSize = batch.size();
+    for (const Segment &segment : delta)
+      deltaSize += segment->size();
+    while (!delta.empty() && delta.back()->size() <= batch.size()) {
+      std::vector<DeltaEdge> merged;
+      merged.reserve(delta.back()->size() + batch.size());
+      std::merge(delta.back()->begin(), delta.back()->end(), batch.begin(),
+                 batch.end(), std::back_inserter(merged), bySource);
+      batch.swap(merged);
+      delta.pop_back();
+    }
+    delta.push_back(
+        std::make_shared<const std::vector<DeltaEdge>>(std::move(batch)));
+
+    if (deltaSize >= compactThreshold)
+      publish(merge(*s->base, delta, s->vertexCount));
+    else
+      publish(new Snapshot(s->base, std::move(delta), s->vertexCount));
+  };
+
+  // Fold the delta into a new base adjacency
+  void compact() {
+    std::lock_guard<std::mutex> lock(writer);
+    const Snapshot *s = current.load();
+    publish(merge(*s->base, s->delta, s->vertexCount));
+  };
+
+private:
+  static const int MAX_READERS = 64;
+
+  size_t compactThreshold;
+  std::mutex writer;
+  std::atomic<const Snapshot *> current;
+  std::atomic<uint64_t> epoch;
+  std::mutex slotLock; // guards slotUsed
+  std::condition_variable slotFreed;
+  bool slotUsed[MAX_READERS];
+  std::atomic<uint64_t> announced[MAX_READERS]; // 0 when not reading
+  std::vector<std::pair<const Snapshot *, uint64_t>> retired;
+
+  static bool bySource(const DeltaEdge &a, const DeltaEdge &b) {
+    return a.from < b.from;
+  };
+
+  static Snapshot *merge(const IndexedAdjacency<W> &base,
+                         const std::vector<Segment> &delta, int n) {
+    auto merged = std::make_shared<IndexedAdjacency<W>>();
+    merged->offsets.assign(1, 0);
+    std::vector<typename std::vector<DeltaEdge>::const_iterator> d;
+    for (const Segment &segment : delta)
+      d.push_back(segment->begin());
+    for (int u = 0; u < n; u++) {
+      if (u < base.getSize())
+        for (int i = base.offsets[u]; i < base.offsets[u + 1]; i++) {
+          merged->targets.push_back(base.targets[i]);
+          merged->weights.push_back(base.weights[i]);
+        }
+      for (size_t j = 0; j < delta.size(); j++)
+        for (; d[j] != delta[j]->end() && d[j]->from == u; ++d[j]) {
+          merged->targets.push_back(d[j]->to);
+          merged->weights.push_back(d[j]->weight);
+        }
+      merged->offsets.push_back((int)merged->targets.size());
+    }
+    return new Snapshot(merged, std::vector<Segment>(), n);
+  };
+
+  // Called with the writer mutex held
+  void publish(const Snapshot *next) {
+    const Snapshot *old = current.exchange(next);
+    retired.push_back({old, epoch.fetch_add(1)});
+
+    // Readers that announced an epoch after the retirement saw the new one
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < MAX_READERS; i++) {
+      uint64_t e = announced[i].load();
+      if (e != 0)
+        oldest = std::min(oldest, e);
+    }
+    auto keep = retired.begin();
+    for (auto &r : retired) {
+      if (r.second < oldest)
+        delete r.first;
+      else
+        *keep++ = r;
+    }
+    retired.erase(keep, retired.end());
+  };
+};
+
+// Result of a single-source query: pred[v] is -1 for the source and for
+// unreachable vertices, which have dist[v] == infinity
+template <class W> struct ShortestPathTree {
+  int source;
+  std::vector<int> pred;
+  std::vector<typename WeightTraits<W>::Distance> dist;
+};
+
+class PathWriter {
+  // Formats into a large buffer that is written out in one block when full,
+  // so there is no per-line flush or per-number stream formatting
+public:
+  PathWriter(std::ostream &o, size_t capacity = 1 << 20)
+      : out(o), buffer(capacity), used(0) {};
+  ~PathWriter() { flush(); };
+
+  // Same text as shortestPath: one line per vertex except the source
+  template <class W> void writePaths(const ShortestPathTree<W> &tree) {
+    int n = (int)tree.pred.size();
+    for (int i = 0; i < n; i++) {
+      if (i == tree.source)
+        continue;
+      if (tree.dist[i] == WeightTraits<W>::infinity()) {
+        writeText("Vertex ");
+        writeNumber(i);
+        writeText(" is unreachable from vertex ");
+        writeNumber(tree.source);
+        writeText(".\n");
+        continue;
+      }
+
+      path.clear();
+      for (int j = i; j != -1; j = tree.pred[j])
+        path.push_back(j);
+      for (auto v = path.rbegin(); v != path.rend(); ++v) {
+        writeNumber(*v);
+        writeText(" ");
+      }
+      writeText("\n");
+    }
+  };
+
+  // Compact form: "SPT1", vertex count, source, then the int32 predecessors
+  template <class W> void writeBinary(const ShortestPathTree<W> &tree) {
+    int32_t header[2] = {(int32_t)tree.pred.size(), tree.source};
+    writeBytes("SPT1", 4);
+    writeBytes(header, sizeof(header));
+    writeBytes(tree.pred.data(), tree.pred.size() * sizeof(int32_t));
+  };
+
+  void flush() {
+    out.write(buffer.data(), used);
+    out.flush();
+    used = 0;
+  };
+
+private:
+  std::ostream &out;
+  std::vector<char> buffer;
+  size_t used;
+  std::vector<int> path;
+
+  void writeBytes(const void *data, size_t size) {
+    if (used + size > buffer.size()) {
+      out.write(buffer.data(), used);
+      used = 0;
+    }
+    if (size > buffer.size())
+      out.write((const char *)data, size);
+    else {
+      std::copy((const char *)data, (const char *)data + size,
+                buffer.data() + used);
+      used += size;
+    }
+  };
+
+  void writeText(const char *text) {
+    writeBytes(text, std::char_traits<char>::length(text));
+  };
+
+  void writeNumber(int value) {
+    char digits[16];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    writeBytes(digits, end - digits);
+  };
+};
+
+template <class W> class BasicGraph {
+  using Vertex = BasicVertex<W>;
+  using Edge = BasicEdge<W>;
+  using Traits = WeightTraits<W>;
+
+public:
+  using Weight = typename Traits::Weight;
+  using Distance = typename Traits::Distance;
+
+  BasicGraph()
       : vertexList(new NodeList<Vertex *>()),
         edgeList(new NodeList<Edge *>()) {};
-  Graph(const Graph &g)
+  BasicGraph(const BasicGraph &g)
       : vertexList(new NodeList<Vertex *>()), edgeList(new NodeList<Edge *>()) {
     Node<Vertex *> *curVertex = g.getVertexList()->getHead();
     while (curVertex) {
@@ -297,7 +979,7 @@ public:
     }
   };
 
-  ~Graph() {
+  ~BasicGraph() {
     Node<Vertex *> *v = vertexList->getHead();
     while (v) {
       delete v->getData();
@@ -320,7 +1002,7 @@ public:
       delete v;
   };
 
-  void insertEdge(const int &u, const int &v, const int &w = 1) {
+  void insertEdge(const int &u, const int &v, const Weight &w = 1) {
     Vertex v1(u), v2(v);
     Vertex *uExists = vertexList->exists(&v1)->getData();
     Vertex *vExists = vertexList->exists(&v2)->getData();
@@ -336,9 +1018,9 @@ public:
     // vExists->addConnectedEdge(newEdge);  // Adjacency is directional
   };
 
-  void printAdjacentMatrix(int ***adjMat = nullptr) const {
+  void printAdjacentMatrix(Weight ***adjMat = nullptr) const {
     int n = vertexList->getSize(), u, v;
-    int **adjMatrix = (adjMat) ? *adjMat : nullptr;
+    Weight **adjMatrix = (adjMat) ? *adjMat : nullptr;
     bool freeMemory = false;
     print("Adjacent matrix: ");
 
@@ -359,7 +1041,7 @@ public:
     for (u = 0; u < n; u++) {
       std::cout << (*vertexList)[u] << "\t| ";
       for (v = 0; v < n; v++, std::cout << "\t") {
-        if (adjMatrix[u][v] != INT_MAX)
+        if (adjMatrix[u][v] != Traits::infinity())
           std::cout << adjMatrix[u][v];
         else
           std::cout << "-";
@@ -375,21 +1057,21 @@ public:
     }
   };
 
-  void getAdjacentMatrix(int **&adjMatrix) const {
+  void getAdjacentMatrix(Weight **&adjMatrix) const {
     // Get the number of vertices
     int dim = vertexList->getSize();
     if (dim == 0)
       return;
 
     // Allocate memory for the adjacency matrix
-    adjMatrix = new int *[dim];
+    adjMatrix = new Weight *[dim];
     for (int i = 0; i < dim; i++)
-      adjMatrix[i] = new int[dim];
+      adjMatrix[i] = new Weight[dim];
 
     // Initialize the matrix elements to highest possible value
     for (int i = 0; i < dim; i++)
       for (int j = 0; j < dim; j++)
-        adjMatrix[i][j] = INT_MAX;
+        adjMatrix[i][j] = Traits::infinity();
 
     // Populate the adjacency matrix
     Node<Vertex *> *p = vertexList->getHead();
@@ -432,14 +1114,15 @@ public:
     return false;
   };
 
-  Edge *getEdge(const int &u, const int &v, const int &w = INT_MAX) const {
+  Edge *getEdge(const int &u, const int &v,
+                const Weight &w = Traits::infinity()) const {
     Node<Edge *> *e = edgeList->getHead();
     while (e) {
       if (((*e->getData())[0]->getData() == u &&
            (*e->getData())[1]->getData() == v) ||
           ((*e->getData())[1]->getData() == u &&
            (*e->getData())[0]->getData() == v)) {
-        if (w == INT_MAX || e->getData()->getWeight() == w)
+        if (w == Traits::infinity() || e->getData()->getWeight() == w)
           return e->getData();
       }
       e = e->getNext();
@@ -450,9 +1133,82 @@ public:
   NodeList<Vertex *> *getVertexList() const { return vertexList; };
   NodeList<Edge *> *getEdgeList() const { return edgeList; };
 
+  // visit(from index, to index, weight) for every edge, vertices indexed by
+  // their vertex list position
+  template <class F> void forEachIndexedEdge(F visit) const {
+    std::unordered_map<Vertex *, int> index;
+    Node<Vertex *> *v = vertexList->getHead();
+    for (int i = 0; v; i++, v = v->getNext())
+      index[v->getData()] = i;
+
+    v = vertexList->getHead();
+    while (v) {
+      Node<Edge *> *e = v->getData()->getConnectedEdges()->getHead();
+      while (e) {
+        Vertex *otherEnd = e->getData()->getAnotherEnd(v->getData());
+        visit(index[v->getData()], index[otherEnd], e->getData()->getWeight());
+        e = e->getNext();
+      }
+      v = v->getNext();
+    }
+  };
+
+  void getIndexedAdjacency(IndexedAdjacency<W> &adj) const {
+    std::unordered_map<Vertex *, int> index;
+    Node<Vertex *> *v = vertexList->getHead();
+    for (int i = 0; v; i++, v = v->getNext())
+      index[v->getData()] = i;
+
+    adj.offsets.assign(1, 0);
+    adj.targets.clear();
+    adj.weights.clear();
+    v = vertexList->getHead();
+    while (v) {
+      Node<Edge *> *e = v->getData()->getConnectedEdges()->getHead();
+      while (e) {
+        adj.targets.push_back(index[e->getData()->getAnotherEnd(v->getData())]);
+        adj.weights.push_back(e->getData()->getWeight());
+        e = e->getNext();
+      }
+      adj.offsets.push_back((int)adj.targets.size());
+      v = v->getNext();
+    }
+  };
+
+  void shortestPathTree(int source, ShortestPathTree<W> &tree) const {
+    STATS_PHASE("shortestPathTree");
+    IndexedAdjacency<W> adj;
+    getIndexedAdjacency(adj);
+    DijkstraWorkspace<W> workspace(adj);
+    workspace.run(source);
+
+    int n = adj.getSize();
+    tree.source = source;
+    tree.pred.resize(n);
+    tree.dist.resize(n);
+    for (int v = 0; v < n; v++) {
+      tree.pred[v] = workspace.getPredecessor(v);
+      tree.dist[v] = workspace.getDistance(v);
+    }
+  };
+
   void shortestPath() const;
+  void partitionedShortestPath(int workers = 2, bool unweighted = false) const;
+
+  // Yen's k shortest loopless paths from source to target (vertex indices),
+  // cheapest first; fewer than k are returned when no more paths exist
+  void kShortestPaths(
+      int source, int target, int k,
+      std::vector<std::pair<Distance, std::vector<int>>> &paths,
+      int threads = 0) const;
 
 private:
+  struct Path {
+    Distance cost;
+    std::vector<int> vertices;
+    std::vector<int> edges; // adjacency slots
+  };
+
   NodeList<Vertex *> *vertexList;
   NodeList<Edge *> *edgeList;
 
@@ -522,89 +1278,429 @@ private:
   };
 };
 
-void Graph::shortestPath() const {
-  int **adjMatrix = nullptr;
-  getAdjacentMatrix(adjMatrix);
-  int mDim = vertexList->getSize();
+template <class W> void BasicGraph<W>::shortestPath() const {
+  if (vertexList->getSize() == 0)
+    return;
+
+  // Display the shortest path from vertex 0 to all other vertices
+  ShortestPathTree<W> tree;
+  shortestPathTree(0, tree);
+  STATS_PHASE("writePaths");
+  PathWriter writer(std::cout);
+  writer.writePaths(tree);
+}
+
+template <class W>
+void BasicGraph<W>::kShortestPaths(
+    int source, int target, int k,
+    std::vector<std::pair<Distance, std::vector<int>>> &paths,
+    int threads) const {
+  STATS_PHASE("kShortestPaths");
+  int n = vertexList->getSize();
+  paths.clear();
+  if (k <= 0 || source < 0 || source >= n || target < 0 || target >= n)
+    return;
+
+  IndexedAdjacency<W> adj;
+  getIndexedAdjacency(adj);
+  if (threads <= 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<DijkstraWorkspace<W>> workspaces(threads,
+                                               DijkstraWorkspace<W>(adj));
+
+  std::vector<Path> shortest(1);
+  workspaces[0].run(source, target);
+  if (!workspaces[0].getPath(target, shortest[0].vertices, &shortest[0].edges))
+    return;
+  shortest[0].cost = workspaces[0].getDistance(target);
+
+  auto cheaper = [](const Path &a, const Path &b) {
+    return a.cost < b.cost || (a.cost == b.cost && a.vertices < b.vertices);
+  };
+  std::set<Path, decltype(cheaper)> candidates(cheaper);
+  std::set<std::vector<int>> known = {shortest[0].vertices};
+
+  while ((int)shortest.size() < k) {
+    const Path &previous = shortest.back();
+    int spurCount = (int)previous.vertices.size() - 1;
+    std::vector<Path> spurPaths(spurCount);
+    std::vector<char> found(spurCount, 0);
+    std::atomic<int> nextSpur(0);
+
+    // Every spur node of the previous path is searched independently
+    auto work = [&](int t) {
+      DijkstraWorkspace<W> &ws = workspaces[t];
+      int i;
+      while ((i = nextSpur.fetch_add(1)) < spurCount) {
+        // Paths are told apart by their vertices, so every parallel slot
+        // leading to the next vertex of a path sharing this root is banned
+        int u = previous.vertices[i];
+        std::vector<int> banned;
+        for (const Path &p : shortest)
+          if ((int)p.vertices.size() > i + 1 &&
+              std::equal(p.vertices.begin(), p.vertices.begin() + i + 1,
+                         previous.vertices.begin()))
+            for (int e = adj.offsets[u]; e < adj.offsets[u + 1]; e++)
+              if (adj.targets[e] == p.vertices[i + 1])
+                banned.push_back(e);
+        for (int e : banned)
+          ws.banEdge(e);
+        for (int j = 0; j < i; j++)
+          ws.banVertex(previous.vertices[j]);
+
+        Path &spur = spurPaths[i];
+        ws.run(previous.vertices[i], target);
+        found[i] = ws.getPath(target, spur.vertices, &spur.edges);
+        spur.cost = ws.getDistance(target);
+
+        for (int e : banned)
+          ws.banEdge(e, false);
+        for (int j = 0; j < i; j++)
+          ws.banVertex(previous.vertices[j], false);
+      }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < std::min(threads, spurCount); t++)
+      pool.emplace_back(work, t);
+    work(0);
+    for (auto &th : pool)
+      th.join();
+
+    // Prefix the root path of the previous result to every spur path
+    for (int i = 0; i < spurCount; i++) {
+      if (!found[i])
+        continue;
+      Path candidate;
+      candidate.cost = 0;
+      bool fits = true;
+      for (int j = 0; j < i && fits; j++)
+        fits = Traits::add(candidate.cost, adj.weights[previous.edges[j]],
+                           candidate.cost);
+      if (!fits || !Traits::add(candidate.cost, spurPaths[i].cost,
+                                candidate.cost))
+        continue;
+
+      candidate.vertices.assign(previous.vertices.begin(),
+                                previous.vertices.begin() + i);
+      candidate.vertices.insert(candidate.vertices.end(),
+                                spurPaths[i].vertices.begin(),
+                                spurPaths[i].vertices.end());
+      candidate.edges.assign(previous.edges.begin(),
+                             previous.edges.begin() + i);
+      candidate.edges.insert(candidate.edges.end(), spurPaths[i].edges.begin(),
+                             spurPaths[i].edges.end());
+      if (known.insert(candidate.vertices).second)
+        candidates.insert(candidate);
+    }
+
+    if (candidates.empty())
+      break;
+    shortest.push_back(*candidates.begin());
+    candidates.erase(candidates.begin());
+  }
+
+  for (const Path &p : shortest)
+    paths.push_back({p.cost, p.vertices});
+}
+
+using Graph = BasicGraph<int>;
+using UnweightedGraph = BasicGraph<void>;
+
+template <class W> class PartitionedEngine {
+  using Traits = WeightTraits<W>;
+  using Weight = typename Traits::Weight;
+  using Distance = typename Traits::Distance;
+  static_assert(std::is_trivially_copyable<Weight>::value &&
+                    std::is_trivially_copyable<Distance>::value,
+                "weights travel over the socket as raw bytes");
+
+  // Vertices are split round-robin across forked worker processes, each one
+  // owning the out-edges of its vertices. Workers are forked before any edge
+  // is read and only receive their own partition, so no process holds the
+  // whole graph. Workers only talk to the coordinator over a Unix socket
+  // pair; every superstep the coordinator routes relaxation messages to the
+  // owner of the target vertex, until no distance improves (Bellman-Ford in
+  // bulk synchronous rounds).
+public:
+  enum Status { DONE, NEGATIVE_CYCLE, FAILED };
+
+  PartitionedEngine(int n, int workers = 2)
+      : vertexCount(n), workerCount(std::max(1, workers)) {};
+
+  // forEachEdge(visit) calls visit(from, to, weight) for every edge. dist[v]
+  // is Traits::infinity() when v is unreachable, pred[v] is -1 for the source.
+  template <class Source>
+  Status run(int source, Source forEachEdge, std::vector<Distance> &dist,
+             std::vector<int> &pred, bool unweighted = false) const {
+    dist.assign(vertexCount, Traits::infinity());
+    pred.assign(vertexCount, -1);
+    if (source < 0 || source >= vertexCount)
+      return FAILED;
+
+    std::vector<int> sockets;
+    std::vector<pid_t> pids;
+    for (int w = 0; w < workerCount; w++) {
+      int fds[2];
+      if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        return stop(sockets, pids);
+
+      pid_t pid = fork();
+      if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return stop(sockets, pids);
+      }
+      if (pid == 0) {
+        close(fds[0]);
+        for (int fd : sockets)
+          close(fd);
+        serve(w, fds[1], unweighted);
+        _exit(0);
+      }
+      close(fds[1]);
+      sockets.push_back(fds[0]);
+      pids.push_back(pid);
+    }
+
+    // Stream every edge to the worker owning its source
+    bool ok = true;
+    std::vector<std::vector<EdgeRecord>> loads(workerCount);
+    forEachEdge([&](int u, int v, const Weight &w) {
+      if (!ok || u < 0 || u >= vertexCount || v < 0 || v >= vertexCount)
+        return;
+      std::vector<EdgeRecord> &load = loads[owner(u)];
+      load.push_back({u, v, w});
+      if (load.size() == LOAD_BATCH) {
+        ok = sendBatch(sockets[owner(u)], LOAD, load);
+        load.clear();
+      }
+    });
+    for (int w = 0; ok && w < workerCount; w++)
+      ok = loads[w].empty() || sendBatch(sockets[w], LOAD, loads[w]);
+    if (!ok)
+      return stop(sockets, pids);
+    loads.clear();
+
+    // Coordinator loop
+    std::vector<std::vector<Message>> outbox(workerCount);
+    outbox[owner(source)].push_back({source, -1, Distance()});
+    bool pending = true;
+    for (int step = 0; pending && step <= vertexCount; step++) {
+      for (int w = 0; w < workerCount; w++) {
+        if (!sendBatch(sockets[w], STEP, outbox[w]))
+          return stop(sockets, pids);
+        outbox[w].clear();
+      }
+
+      pending = false;
+      std::vector<Message> inbox;
+      for (int w = 0; w < workerCount; w++) {
+        if (!receiveBatch(sockets[w], STEP, inbox))
+          return stop(sockets, pids);
+        for (const Message &m : inbox) {
+          outbox[owner(m.vertex)].push_back(m);
+          pending = true;
+        }
+      }
+    }
+
+    std::vector<Message> result;
+    for (int w = 0; w < workerCount; w++) {
+      if (!sendBatch(sockets[w], FINISH, std::vector<Message>()) ||
+          !receiveBatch(sockets[w], FINISH, result))
+        return stop(sockets, pids);
+      for (const Message &m : result) {
+        dist[m.vertex] = m.dist;
+        pred[m.vertex] = m.pred;
+      }
+    }
+    stop(sockets, pids);
+
+    // Messages were still in flight after |V| rounds: negative cycle
+    return pending ? NEGATIVE_CYCLE : DONE;
+  };
+
+private:
+  enum Command : int32_t { LOAD, STEP, FINISH };
+  struct Message {
+    int32_t vertex;
+    int32_t pred;
+    Distance dist;
+  };
+  struct EdgeRecord {
+    int32_t from;
+    int32_t to;
+    Weight weight;
+  };
+  struct Header {
+    int32_t command;
+    int64_t count;
+  };
+  static const size_t LOAD_BATCH = 1 << 16;
+
+  int vertexCount;
+  int workerCount;
 
-  // Initialize distances as infinity, except for the source vertex (0)
-  std::vector<int> dist(mDim, INT_MAX);
-  dist[0] = 0;
-
-  // Predecessor array to track the shortest path
-  std::vector<int> pred(mDim, -1); // -1 means no predecessor (start node)
-
-  // Priority queue (min-heap), holds pairs of (distance, vertex)
-  auto compare = [](std::pair<int, Vertex *> &a, std::pair<int, Vertex *> &b) {
-    return a.first >
-           b.first; // Min-heap comparison based on the first element (distance)
-  };
-  std::priority_queue<std::pair<int, Vertex *>,
-                      std::vector<std::pair<int, Vertex *>>, decltype(compare)>
-      pq(compare);
-
-  // Add the source vertex to the priority queue
-  pq.push({0, vertexList->getHead()->getData()});
-
-  // Dijkstra's algorithm
-  while (!pq.empty()) {
-    // Get the vertex with the smallest distance
-    auto [curDist, curVertex] = pq.top();
-    pq.pop();
-
-    // Skip if this vertex has already been processed
-    if (curDist > dist[vertexList->getIndex(curVertex)])
-      continue;
-
-    // Check all adjacent vertices
-    Node<Edge *> *edges = curVertex->getConnectedEdges()->getHead();
-    while (edges) {
-      Edge *edge = edges->getData();
-      Vertex *neighbor = edge->getAnotherEnd(curVertex);
-
-      int newDist = curDist + edge->getWeight();
-      int neighborIndex = vertexList->getIndex(neighbor);
-
-      // If a shorter path to the neighbor is found, update it
-      if (newDist < dist[neighborIndex]) {
-        dist[neighborIndex] = newDist;
-        pred[neighborIndex] =
-            vertexList->getIndex(curVertex); // Track the predecessor
-        pq.push({dist[neighborIndex], neighbor});
+  int owner(int v) const { return v % workerCount; };
+  // Position of v among the vertices of its owner
+  int local(int v) const { return v / workerCount; };
+  int ownedCount(int self) const {
+    return (vertexCount - self + workerCount - 1) / workerCount;
+  };
+
+  // Closing the sockets makes every worker leave its receive loop
+  static Status stop(std::vector<int> &sockets, std::vector<pid_t> &pids) {
+    for (int fd : sockets)
+      close(fd);
+    for (pid_t pid : pids)
+      waitpid(pid, nullptr, 0);
+    sockets.clear();
+    pids.clear();
+    return FAILED;
+  };
+
+  void serve(int self, int fd, bool unweighted) const {
+    int owned = ownedCount(self);
+    std::vector<EdgeRecord> edges, batch;
+    std::vector<int> offset, target;
+    std::vector<Weight> weight;
+    std::vector<Distance> dist(owned, Traits::infinity());
+    std::vector<int> pred(owned, -1);
+    std::vector<Message> inbox, outbox;
+    Header header;
+
+    bool ok;
+    while ((ok = receiveHeader(fd, header)) && header.command == LOAD) {
+      if (!receiveRecords(fd, header.count, batch))
+        return (void)close(fd);
+      edges.insert(edges.end(), batch.begin(), batch.end());
+    }
+    if (!ok)
+      return (void)close(fd);
+
+    // Local CSR of the out-edges owned by this worker
+    offset.assign(owned + 1, 0);
+    for (const EdgeRecord &e : edges)
+      offset[local(e.from) + 1]++;
+    for (int v = 0; v < owned; v++)
+      offset[v + 1] += offset[v];
+    target.resize(edges.size());
+    weight.resize(edges.size());
+    std::vector<int> fill(offset.begin(), offset.end() - 1);
+    for (const EdgeRecord &e : edges) {
+      target[fill[local(e.from)]] = e.to;
+      weight[fill[local(e.from)]++] = unweighted ? Weight(1) : e.weight;
+    }
+    std::vector<EdgeRecord>().swap(edges);
+
+    while (header.command == STEP) {
+      if (!receiveRecords(fd, header.count, inbox))
+        return (void)close(fd);
+      outbox.clear();
+      for (const Message &m : inbox) {
+        int v = local(m.vertex);
+        if (m.dist >= dist[v])
+          continue;
+        dist[v] = m.dist;
+        pred[v] = m.pred;
+        for (int i = offset[v]; i < offset[v + 1]; i++) {
+          Distance sum;
+          if (Traits::add(m.dist, weight[i], sum))
+            outbox.push_back({target[i], m.vertex, sum});
+        }
       }
+      if (!sendBatch(fd, STEP, outbox) || !receiveHeader(fd, header))
+        return (void)close(fd);
+    }
 
-      edges = edges->getNext();
+    if (header.command == FINISH && receiveRecords(fd, header.count, inbox)) {
+      outbox.clear();
+      for (int v = 0; v < owned; v++)
+        outbox.push_back({self + v * workerCount, pred[v], dist[v]});
+      sendBatch(fd, FINISH, outbox);
     }
+    close(fd);
+  };
+
+  // Writes use MSG_NOSIGNAL: a peer that went away is an error, not SIGPIPE
+  static bool transfer(int fd, void *buffer, size_t size, bool reading) {
+    char *p = (char *)buffer;
+    while (size > 0) {
+      ssize_t done =
+          reading ? read(fd, p, size) : send(fd, p, size, MSG_NOSIGNAL);
+      if (done < 0 && errno == EINTR)
+        continue;
+      if (done <= 0)
+        return false;
+      p += done;
+      size -= done;
+    }
+    return true;
+  };
+
+  template <class T>
+  static bool sendBatch(int fd, int32_t command, const std::vector<T> &batch) {
+    Header header = {command, (int64_t)batch.size()};
+    return transfer(fd, &header, sizeof(header), false) &&
+           transfer(fd, (void *)batch.data(), batch.size() * sizeof(T),
+                    false);
+  };
+
+  static bool receiveHeader(int fd, Header &header) {
+    return transfer(fd, &header, sizeof(header), true) && header.count >= 0;
+  };
+
+  template <class T>
+  static bool receiveRecords(int fd, int64_t count, std::vector<T> &batch) {
+    batch.resize(count);
+    return transfer(fd, batch.data(), count * sizeof(T), true);
+  };
+
+  // A batch answering command, false on any error
+  template <class T>
+  static bool receiveBatch(int fd, int32_t command, std::vector<T> &batch) {
+    Header header;
+    return receiveHeader(fd, header) && header.command == command &&
+           receiveRecords(fd, header.count, batch);
+  };
+};
+
+template <class W>
+void BasicGraph<W>::partitionedShortestPath(int workers,
+                                           bool unweighted) const {
+  std::vector<typename Traits::Distance> dist;
+  std::vector<int> pred;
+  int mDim = vertexList->getSize();
+
+  PartitionedEngine<W> engine(mDim, workers);
+  auto status = engine.run(
+      0, [this](auto visit) { forEachIndexedEdge(visit); }, dist, pred,
+      unweighted || !Traits::weighted);
+  if (status == PartitionedEngine<W>::FAILED) {
+    std::cerr << "Partitioned shortest path failed" << std::endl;
+    return;
+  }
+  if (status == PartitionedEngine<W>::NEGATIVE_CYCLE) {
+    std::cerr << "Negative cycle reachable from vertex 0" << std::endl;
+    return;
   }
 
-  // Display the shortest path from vertex 0 to all other vertices
   for (int i = 1; i < mDim; ++i) {
-    if (dist[i] == INT_MAX) {
+    if (dist[i] == Traits::infinity()) {
       std::cout << "Vertex " << i << " is unreachable from vertex 0."
                 << std::endl;
     } else {
-      // Reconstruct the path from vertex 0 to vertex i
       std::vector<int> path;
-      for (int j = i; j != -1; j = pred[j]) {
+      for (int j = i; j != -1; j = pred[j])
         path.push_back(j);
-      }
-
-      // Reverse the path to display it from 0 to i
       std::reverse(path.begin(), path.end());
 
-      // Print the path and its cost
-      for (int v : path) {
+      for (int v : path)
         std::cout << v << " ";
-      }
       std::cout << std::endl;
     }
   }
-
-  // Clean up
-  for (int i = 0; i < mDim; i++) {
-    delete[] adjMatrix[i];
-  }
-  delete[] adjMatrix;
 }
 
 void test(Graph *g);
@@ -629,6 +1725,7 @@ int main() {
 
   g.shortestPath();
 
+  STATS_DUMP(std::cerr);
   return 0;
 }
 